@@ -0,0 +1,214 @@
+#pragma once
+// Общие части инструментов, работающих против запущенного сервера
+// (financial_manager_load, financial_manager_replay, financial_manager_stress):
+// отправка запроса с повтором ответов 429/503 после Retry-After, статистика
+// маршрута, перцентили и разбор аргументов командной строки.
+#include <drogon/HttpClient.h>
+#include <drogon/utils/coroutine.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+struct Request {
+    drogon::HttpMethod method = drogon::Get;
+    // Путь; параметры после '?' ("/transactions?family=true") передаются
+    // отдельно от пути
+    std::string path;
+    const Json::Value *body = nullptr;
+    std::string token;
+};
+
+// Повтор ответов 429/503: не больше attempts повторов, пауза из Retry-After
+// в пределах [minWaitSec, maxWaitSec]. attempts = 0 — без повторов.
+struct Retry {
+    int attempts = 0;
+    double minWaitSec = 0.1;
+    double maxWaitSec = 10;
+};
+
+// Вызывается на каждую попытку: ответ (nullptr — сетевая ошибка) и задержка
+using Observer = std::function<void(const drogon::HttpResponsePtr &, double latencyMs)>;
+
+inline drogon::HttpRequestPtr makeRequest(const Request &r) {
+    auto req = r.body ? drogon::HttpRequest::newHttpJsonRequest(*r.body)
+                      : drogon::HttpRequest::newHttpRequest();
+    req->setMethod(r.method);
+    const auto query = r.path.find('?');
+    req->setPath(r.path.substr(0, query));
+    if (query != std::string::npos) {
+        const std::string params = r.path.substr(query + 1);
+        size_t pos = 0;
+        while (pos < params.size()) {
+            const auto amp = std::min(params.find('&', pos), params.size());
+            const std::string pair = params.substr(pos, amp - pos);
+            const auto eq = pair.find('=');
+            if (!pair.empty()) {
+                req->setParameter(pair.substr(0, eq),
+                                  eq == std::string::npos ? "" : pair.substr(eq + 1));
+            }
+            pos = amp + 1;
+        }
+    }
+    if (!r.token.empty()) {
+        req->addHeader("Authorization", "Bearer " + r.token);
+    }
+    return req;
+}
+
+inline bool isThrottled(const drogon::HttpResponsePtr &resp) {
+    const int status = resp ? static_cast<int>(resp->statusCode()) : 0;
+    return status == 429 || status == 503;
+}
+
+// Пауза перед повтором по заголовку Retry-After (секунды)
+inline double retryAfterSec(const drogon::HttpResponsePtr &resp, const Retry &retry) {
+    const double wait = std::atof(resp->getHeader("retry-after").c_str());
+    return std::clamp(wait, retry.minWaitSec, retry.maxWaitSec);
+}
+
+// Выполняет запрос в loop клиента. Сетевая ошибка и истёкший таймаут
+// возвращают nullptr.
+inline drogon::Task<drogon::HttpResponsePtr> send(drogon::HttpClientPtr client,
+                                                  trantor::EventLoop *loop,
+                                                  Request request,
+                                                  double timeoutSec,
+                                                  Retry retry = {},
+                                                  Observer observe = {}) {
+    for (int attempt = 0;; ++attempt) {
+        const auto start = Clock::now();
+        drogon::HttpResponsePtr resp;
+        try {
+            resp = co_await client->sendRequestCoro(makeRequest(request), timeoutSec);
+        } catch (const std::exception &) {
+            if (observe) {
+                observe(nullptr, 0);
+            }
+            co_return nullptr;
+        }
+        if (observe) {
+            observe(resp, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        if (!isThrottled(resp) || attempt >= retry.attempts) {
+            co_return resp;
+        }
+        co_await drogon::sleepCoro(loop, retryAfterSec(resp, retry));
+    }
+}
+
+inline bool isSuccess(const drogon::HttpResponsePtr &resp) {
+    return resp && static_cast<int>(resp->statusCode()) < 300;
+}
+
+// id созданной строки из успешного ответа, иначе 0
+inline int64_t jsonId(const drogon::HttpResponsePtr &resp) {
+    auto json = isSuccess(resp) ? resp->getJsonObject() : nullptr;
+    return json ? (*json)["id"].asInt64() : 0;
+}
+
+// Исходы и задержки запросов одного маршрута
+struct RouteStats {
+    int64_t ok = 0;
+    int64_t clientErrors = 0;
+    int64_t serverErrors = 0;
+    int64_t networkErrors = 0;
+    std::vector<double> latenciesMs;
+
+    void record(const drogon::HttpResponsePtr &resp, double latencyMs) {
+        if (!resp) {
+            ++networkErrors;
+            return;
+        }
+        latenciesMs.push_back(latencyMs);
+        const int status = static_cast<int>(resp->statusCode());
+        if (status >= 500) {
+            ++serverErrors;
+        } else if (status >= 400) {
+            ++clientErrors;
+        } else {
+            ++ok;
+        }
+    }
+
+    void merge(const RouteStats &other) {
+        ok += other.ok;
+        clientErrors += other.clientErrors;
+        serverErrors += other.serverErrors;
+        networkErrors += other.networkErrors;
+        latenciesMs.insert(latenciesMs.end(), other.latenciesMs.begin(), other.latenciesMs.end());
+    }
+
+    int64_t requests() const {
+        return static_cast<int64_t>(latenciesMs.size()) + networkErrors;
+    }
+};
+
+// Перцентиль p (0..1) отсортированной выборки методом ближайшего ранга
+inline double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+// Разбор "--флаг значение". Неизвестный флаг или флаг без значения
+// печатает usage и завершает процесс с кодом 2.
+//
+//   bench::Args args(argc, argv, "[--url URL] [--users N]");
+//   while (args.next()) {
+//       if (args.is("--url")) url = args.value();
+//       else if (args.is("--users")) users = args.intValue(1);
+//       else args.usage();
+//   }
+class Args {
+public:
+    Args(int argc, char **argv, const char *synopsis)
+        : argc_(argc), argv_(argv), synopsis_(synopsis) {}
+
+    bool next() { return ++i_ < argc_; }
+
+    bool is(const char *flag) const { return std::strcmp(argv_[i_], flag) == 0; }
+
+    const char *value() {
+        if (i_ + 1 >= argc_) {
+            usage();
+        }
+        return argv_[++i_];
+    }
+
+    // Числовые значения не меньше min
+    int intValue(int min) { return std::max(min, std::atoi(value())); }
+    int64_t int64Value(int64_t min) { return std::max<int64_t>(min, std::atoll(value())); }
+    double doubleValue(double min) { return std::max(min, std::atof(value())); }
+
+    [[noreturn]] void usage() const {
+        std::fprintf(stderr, "usage: %s %s\n", argv_[0], synopsis_);
+        std::exit(2);
+    }
+
+private:
+    int argc_;
+    char **argv_;
+    const char *synopsis_;
+    int i_ = 0;
+};
+
+// Метка прогона для уникальных email синтетических пользователей
+inline std::string defaultRunId() {
+    return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count());
+}
+
+}
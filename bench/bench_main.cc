@@ -0,0 +1,222 @@
+// Микробенчмарки горячих путей приложения. Каждый результат печатается
+// отдельной строкой JSON, чтобы сравнивать прогоны между релизами:
+//   {"benchmark":"money/format_amount","rows":1,"iterations":...,"ns_per_op":...}
+#include <drogon/HttpRequest.h>
+#include <jsoncpp/json/json.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "models/Transactions.h"
+#include "utils/JwtUtils.h"
+#include "utils/Money.h"
+#include "utils/PasswordUtils.h"
+
+using drogon_model::financial_manager::Transactions;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string gFilter;
+Clock::duration gMinTime = std::chrono::milliseconds(200);
+
+// Не даёт компилятору выбросить вычисление результата
+template <typename T>
+inline void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Удваивает число итераций, пока серия не займёт не меньше gMinTime,
+// и печатает время последней серии
+template <typename Fn>
+void bench(const std::string &name, int64_t rows, Fn &&fn) {
+    if (!gFilter.empty() && name.find(gFilter) == std::string::npos) {
+        return;
+    }
+    fn();
+    int64_t iterations = 1;
+    for (;;) {
+        const auto start = Clock::now();
+        for (int64_t i = 0; i < iterations; ++i) {
+            fn();
+        }
+        const auto elapsed = Clock::now() - start;
+        if (elapsed >= gMinTime || iterations >= (int64_t{1} << 40)) {
+            const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+            const double nsPerOp = ns / static_cast<double>(iterations);
+            std::printf("{\"benchmark\":\"%s\",\"rows\":%lld,\"iterations\":%lld,"
+                        "\"ns_per_op\":%.1f,\"ops_per_sec\":%.1f}\n",
+                        name.c_str(), static_cast<long long>(rows),
+                        static_cast<long long>(iterations), nsPerOp, 1e9 / nsPerOp);
+            std::fflush(stdout);
+            return;
+        }
+        iterations *= 2;
+    }
+}
+
+std::vector<Transactions> makeTransactions(size_t count) {
+    std::vector<Transactions> rows;
+    rows.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        Json::Value json;
+        json["id"] = static_cast<Json::Int>(i + 1);
+        json["id_user"] = 42;
+        json["id_account"] = static_cast<Json::Int>(i % 7 + 1);
+        json["id_category"] = static_cast<Json::Int>(i % 13 + 1);
+        json["amount"] = money::formatAmount(12.5 + static_cast<double>(i % 1000));
+        json["type"] = i % 3 == 0 ? "income" : "expense";
+        json["description"] = "Покупка \"продуктов\" #" + std::to_string(i);
+        json["created_at"] = "2024-03-15 12:34:56";
+        json["is_family"] = false;
+        rows.emplace_back(json);
+    }
+    return rows;
+}
+
+// Как в GetTransactions: toJson по строкам и сериализация массива
+std::string serializeViaJson(const std::vector<Transactions> &rows) {
+    Json::Value arr(Json::arrayValue);
+    for (const auto &t : rows) {
+        auto trJson = t.toJson();
+        trJson["is_family"] = false;
+        arr.append(trJson);
+    }
+    static const Json::StreamWriterBuilder builder = [] {
+        Json::StreamWriterBuilder b;
+        b["indentation"] = "";
+        b["emitUTF8"] = true;
+        return b;
+    }();
+    return Json::writeString(builder, arr);
+}
+
+void appendEscaped(std::string &out, const std::string &value) {
+    out += '"';
+    for (char c : value) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+// Запись тех же полей сразу в строку, без промежуточного Json::Value
+std::string serializeDirect(const std::vector<Transactions> &rows) {
+    std::string out;
+    out.reserve(rows.size() * 256 + 2);
+    out += '[';
+    bool first = true;
+    for (const auto &t : rows) {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        out += "{\"amount\":";
+        appendEscaped(out, t.getValueOfAmount());
+        out += ",\"created_at\":";
+        appendEscaped(out, t.getValueOfCreatedAt().toDbStringLocal());
+        out += ",\"description\":";
+        appendEscaped(out, t.getValueOfDescription());
+        out += ",\"id\":";
+        out += std::to_string(t.getValueOfId());
+        out += ",\"id_account\":";
+        out += std::to_string(t.getValueOfIdAccount());
+        out += ",\"id_category\":";
+        out += std::to_string(t.getValueOfIdCategory());
+        out += ",\"id_user\":";
+        out += std::to_string(t.getValueOfIdUser());
+        out += ",\"is_family\":false,\"type\":";
+        appendEscaped(out, t.getValueOfType());
+        out += '}';
+    }
+    out += ']';
+    return out;
+}
+
+void parseArgs(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            gFilter = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+            gMinTime = std::chrono::milliseconds(std::atoll(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter <substring>] [--min-time-ms <ms>]\n", argv[0]);
+            std::exit(2);
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    parseArgs(argc, argv);
+
+    // --- JWT ---
+    bench("jwt/create_token", 1, [] {
+        doNotOptimize(jwt_utils::createToken(42, "user@example.com"));
+    });
+    const std::string token = jwt_utils::createToken(42, "user@example.com");
+    bench("jwt/get_user_id", 1, [&token] {
+        // Новый запрос на каждой итерации: результат кэшируется в атрибутах запроса
+        auto req = drogon::HttpRequest::newHttpRequest();
+        req->addHeader("Authorization", "Bearer " + token);
+        doNotOptimize(jwt_utils::getUserIdFromRequest(req));
+    });
+
+    // --- пароли (параметры по умолчанию) ---
+    bench("password/hash", 1, [] {
+        doNotOptimize(security::hashPassword("correct horse battery staple"));
+    });
+    const std::string hash = security::hashPassword("correct horse battery staple");
+    bench("password/verify", 1, [&hash] {
+        doNotOptimize(security::verifyPassword("correct horse battery staple", hash));
+    });
+
+    // --- суммы ---
+    const std::string amount = "123456.78";
+    bench("money/parse_amount", 1, [&amount] {
+        doNotOptimize(money::parseAmount(amount));
+    });
+    double value = 123456.785;
+    bench("money/format_amount", 1, [&value] {
+        doNotOptimize(money::formatAmount(value));
+    });
+
+    // --- JSON списка транзакций ---
+    for (size_t rows : {size_t{1}, size_t{100}, size_t{10000}}) {
+        const auto data = makeTransactions(rows);
+        bench("json/transactions_to_json", static_cast<int64_t>(rows), [&data] {
+            doNotOptimize(serializeViaJson(data));
+        });
+        bench("json/transactions_direct", static_cast<int64_t>(rows), [&data] {
+            doNotOptimize(serializeDirect(data));
+        });
+    }
+    return 0;
+}
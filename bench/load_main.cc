@@ -0,0 +1,411 @@
+// Нагрузочный генератор для запущенного сервера. Регистрирует синтетических
+// пользователей (со счетами, категориями, бюджетом) и семьи, затем в течение
+// --duration-sec гоняет смесь сценариев: загрузка дашборда, списки,
+// создание транзакций, переводы, правка бюджетов. По каждому маршруту
+// печатает пропускную способность и p50/p95/p99 строками JSON.
+//
+// Все запросы идут с одного адреса, поэтому сервер запускается без
+// ограничений частоты: `financial_manager --no-rate-limits` (отключает
+// finance::RateLimiter и custom_config.login_throttle). С включёнными
+// лимитами подготовка упрётся в 429 (ответы 429/503 при подготовке
+// повторяются после Retry-After).
+#include "bench/BenchUtils.h"
+#include <trantor/net/EventLoopThreadPool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using drogon::HttpClientPtr;
+using drogon::HttpResponsePtr;
+using drogon::Task;
+using bench::Clock;
+using bench::isSuccess;
+using bench::jsonId;
+using bench::RouteStats;
+
+namespace {
+
+struct Options {
+    std::string url = "http://127.0.0.1:9000";
+    int users = 50;
+    int familySize = 4;
+    int threads = 4;
+    int durationSec = 30;
+    int thinkMs = 0;
+    double timeoutSec = 10;
+    std::string runId;
+};
+
+Options gOptions;
+
+// Поток нагрузки: свой event loop и HTTP-клиент. Все пользователи потока
+// выполняются в его loop, поэтому статистика пишется без блокировок.
+struct Worker {
+    trantor::EventLoop *loop = nullptr;
+    HttpClientPtr client;
+    std::map<std::string, RouteStats> stats;
+    std::mt19937 rng{std::random_device{}()};
+};
+
+struct User {
+    int index = 0;
+    Worker *worker = nullptr;
+    std::string email;
+    std::string password;
+    std::string token;
+    std::vector<int64_t> accounts;
+    int64_t expenseCategory = 0;
+    int64_t budgetId = 0;
+    std::optional<int64_t> familyId;
+    bool ready = false;
+};
+
+// Выполняет запрос и записывает его в статистику маршрута route.
+// При retryThrottled ответы 429/503 повторяются после Retry-After.
+Task<HttpResponsePtr> call(Worker &worker,
+                           const std::string &route,
+                           drogon::HttpMethod method,
+                           const std::string &path,
+                           const Json::Value *body,
+                           const std::string &token,
+                           bool retryThrottled = false) {
+    auto *stats = &worker.stats[route];
+    return bench::send(worker.client, worker.loop, {method, path, body, token}, gOptions.timeoutSec,
+                       retryThrottled ? bench::Retry{20} : bench::Retry{},
+                       [stats](const HttpResponsePtr &resp, double ms) { stats->record(resp, ms); });
+}
+
+// Регистрация, вход, два счёта, категория расходов и бюджет на неё
+Task<> setupUser(User &user) {
+    auto &w = *user.worker;
+    Json::Value body;
+    body["name"] = "Load user " + std::to_string(user.index);
+    body["email"] = user.email;
+    body["password"] = user.password;
+    co_await call(w, "POST /api/auth/register", drogon::Post, "/api/auth/register", &body, "", true);
+
+    Json::Value login;
+    login["email"] = user.email;
+    login["password"] = user.password;
+    auto resp = co_await call(w, "POST /api/auth/login", drogon::Post, "/api/auth/login", &login, "", true);
+    if (!isSuccess(resp) || !resp->getJsonObject()) {
+        co_return;
+    }
+    user.token = (*resp->getJsonObject())["token"].asString();
+
+    for (const char *type : {"card", "cash"}) {
+        Json::Value account;
+        account["account_name"] = std::string("Load ") + type;
+        account["account_type"] = type;
+        account["balance"] = "1000000.00";
+        resp = co_await call(w, "POST /accounts", drogon::Post, "/accounts", &account, user.token, true);
+        if (isSuccess(resp)) {
+            user.accounts.push_back(jsonId(resp));
+        }
+    }
+
+    Json::Value category;
+    category["name"] = "Load groceries";
+    category["type"] = "expense";
+    resp = co_await call(w, "POST /categories", drogon::Post, "/categories", &category, user.token, true);
+    user.expenseCategory = isSuccess(resp) ? jsonId(resp) : 0;
+
+    if (user.expenseCategory) {
+        Json::Value budget;
+        budget["id_category"] = static_cast<Json::Int64>(user.expenseCategory);
+        budget["limit_amount"] = "500.00";
+        budget["month"] = 1;
+        budget["year"] = 2030;
+        resp = co_await call(w, "POST /budgets", drogon::Post, "/budgets", &budget, user.token, true);
+        user.budgetId = isSuccess(resp) ? jsonId(resp) : 0;
+    }
+    user.ready = user.accounts.size() == 2 && user.expenseCategory && user.budgetId;
+}
+
+// Владелец создаёт семью, приглашает следующих familySize - 1 пользователей
+// и принимает приглашения от их имени
+Task<> setupFamily(User &owner, std::vector<User> &users) {
+    auto &w = *owner.worker;
+    if (!owner.ready) {
+        co_return;
+    }
+    Json::Value family;
+    family["name"] = "Load family " + std::to_string(owner.index);
+    auto resp = co_await call(w, "POST /api/family", drogon::Post, "/api/family", &family, owner.token, true);
+    if (!isSuccess(resp)) {
+        co_return;
+    }
+    const int64_t familyId = jsonId(resp);
+    owner.familyId = familyId;
+
+    for (int i = owner.index + 1;
+         i < owner.index + gOptions.familySize && i < static_cast<int>(users.size()); ++i) {
+        auto &member = users[i];
+        if (!member.ready) {
+            continue;
+        }
+        Json::Value invite;
+        invite["email"] = member.email;
+        const std::string invitePath = "/api/family/" + std::to_string(familyId) + "/invite";
+        resp = co_await call(w, "POST /api/family/{id}/invite", drogon::Post, invitePath, &invite,
+                             owner.token, true);
+        if (!isSuccess(resp) || !resp->getJsonObject()) {
+            continue;
+        }
+        const std::string url = (*resp->getJsonObject())["join_url"].asString();
+        const auto pos = url.find("token=");
+        if (pos == std::string::npos) {
+            continue;
+        }
+        Json::Value join;
+        join["token"] = url.substr(pos + 6);
+        join["email"] = member.email;
+        join["password"] = member.password;
+        resp = co_await call(w, "POST /api/family/join", drogon::Post, "/api/family/join", &join, "", true);
+        if (isSuccess(resp)) {
+            member.familyId = familyId;
+        }
+    }
+}
+
+// Сценарии смеси нагрузки и их веса
+Task<> dashboard(User &user) {
+    auto &w = *user.worker;
+    co_await call(w, "GET /accounts", drogon::Get, "/accounts", nullptr, user.token);
+    co_await call(w, "GET /transactions", drogon::Get, "/transactions", nullptr, user.token);
+    co_await call(w, "GET /budgets", drogon::Get, "/budgets", nullptr, user.token);
+    co_await call(w, "GET /categories", drogon::Get, "/categories", nullptr, user.token);
+}
+
+Task<> listPages(User &user) {
+    auto &w = *user.worker;
+    if (user.familyId) {
+        co_await call(w, "GET /transactions?family=true", drogon::Get, "/transactions?family=true",
+                      nullptr, user.token);
+        co_await call(w, "GET /accounts?family=true", drogon::Get, "/accounts?family=true",
+                      nullptr, user.token);
+    } else {
+        co_await call(w, "GET /transactions", drogon::Get, "/transactions", nullptr, user.token);
+    }
+    co_await call(w, "GET /transfers", drogon::Get, "/transfers", nullptr, user.token);
+}
+
+Task<> createTransaction(User &user) {
+    auto &w = *user.worker;
+    std::uniform_int_distribution<int> cents(100, 10000);
+    Json::Value tx;
+    tx["id_account"] = static_cast<Json::Int64>(user.accounts[w.rng() % user.accounts.size()]);
+    tx["amount"] = std::to_string(cents(w.rng) / 100) + "." + std::to_string(10 + cents(w.rng) % 90);
+    tx["type"] = "expense";
+    tx["id_category"] = static_cast<Json::Int64>(user.expenseCategory);
+    tx["description"] = "load";
+    co_await call(w, "POST /transactions", drogon::Post, "/transactions", &tx, user.token);
+}
+
+Task<> transfer(User &user) {
+    auto &w = *user.worker;
+    const bool forward = w.rng() % 2 == 0;
+    Json::Value tr;
+    tr["account_from"] = static_cast<Json::Int64>(user.accounts[forward ? 0 : 1]);
+    tr["account_to"] = static_cast<Json::Int64>(user.accounts[forward ? 1 : 0]);
+    tr["amount"] = "1.00";
+    co_await call(w, "POST /transfers", drogon::Post, "/transfers", &tr, user.token);
+}
+
+Task<> editBudget(User &user) {
+    auto &w = *user.worker;
+    Json::Value budget;
+    budget["limit_amount"] = std::to_string(400 + w.rng() % 200) + ".00";
+    co_await call(w, "PUT /budgets/{id}", drogon::Put, "/budgets/" + std::to_string(user.budgetId),
+                  &budget, user.token);
+}
+
+struct Scenario {
+    const char *name;
+    int weight;
+    std::function<Task<>(User &)> run;
+};
+
+const std::vector<Scenario> &scenarios() {
+    static const std::vector<Scenario> all{
+        {"dashboard", 35, dashboard},
+        {"list_pages", 25, listPages},
+        {"create_transaction", 20, createTransaction},
+        {"transfer", 10, transfer},
+        {"edit_budget", 10, editBudget},
+    };
+    return all;
+}
+
+Task<> runUser(User &user, Clock::time_point until) {
+    if (!user.ready) {
+        co_return;
+    }
+    int totalWeight = 0;
+    for (const auto &s : scenarios()) {
+        totalWeight += s.weight;
+    }
+    auto &w = *user.worker;
+    while (Clock::now() < until) {
+        int pick = static_cast<int>(w.rng() % totalWeight);
+        for (const auto &s : scenarios()) {
+            if (pick < s.weight) {
+                co_await s.run(user);
+                break;
+            }
+            pick -= s.weight;
+        }
+        if (gOptions.thinkMs > 0) {
+            co_await drogon::sleepCoro(w.loop, gOptions.thinkMs / 1000.0);
+        }
+    }
+}
+
+// Запускает fn для каждого выбранного пользователя в loop его потока и ждёт
+// завершения всех
+void runPhase(std::vector<User> &users,
+              const std::function<bool(const User &)> &selected,
+              const std::function<Task<>(User &)> &fn) {
+    auto pending = std::make_shared<std::atomic<int>>(0);
+    auto done = std::make_shared<std::promise<void>>();
+    std::vector<User *> batch;
+    for (auto &user : users) {
+        if (selected(user)) {
+            batch.push_back(&user);
+        }
+    }
+    if (batch.empty()) {
+        return;
+    }
+    pending->store(static_cast<int>(batch.size()));
+    auto finished = done->get_future();
+    for (auto *user : batch) {
+        user->worker->loop->queueInLoop([user, fn, pending, done]() {
+            drogon::async_run([user, fn, pending, done]() -> Task<> {
+                try {
+                    co_await fn(*user);
+                } catch (const std::exception &e) {
+                    std::fprintf(stderr, "user %d: %s\n", user->index, e.what());
+                }
+                if (pending->fetch_sub(1) == 1) {
+                    done->set_value();
+                }
+            });
+        });
+    }
+    finished.wait();
+}
+
+void report(const char *phase, std::vector<Worker> &workers, double seconds) {
+    std::map<std::string, RouteStats> merged;
+    for (auto &w : workers) {
+        for (auto &[route, stats] : w.stats) {
+            merged[route].merge(stats);
+        }
+        w.stats.clear();
+    }
+    int64_t total = 0;
+    for (auto &[route, stats] : merged) {
+        auto &lat = stats.latenciesMs;
+        std::sort(lat.begin(), lat.end());
+        const int64_t count = stats.requests();
+        total += count;
+        std::printf("{\"phase\":\"%s\",\"route\":\"%s\",\"requests\":%lld,\"rps\":%.1f,"
+                    "\"ok\":%lld,\"4xx\":%lld,\"5xx\":%lld,\"network_errors\":%lld,"
+                    "\"p50_ms\":%.2f,\"p95_ms\":%.2f,\"p99_ms\":%.2f,\"max_ms\":%.2f}\n",
+                    phase, route.c_str(), static_cast<long long>(count),
+                    static_cast<double>(count) / seconds,
+                    static_cast<long long>(stats.ok), static_cast<long long>(stats.clientErrors),
+                    static_cast<long long>(stats.serverErrors),
+                    static_cast<long long>(stats.networkErrors),
+                    bench::percentile(lat, 0.50), bench::percentile(lat, 0.95),
+                    bench::percentile(lat, 0.99),
+                    lat.empty() ? 0.0 : lat.back());
+    }
+    std::printf("{\"phase\":\"%s\",\"route\":\"*\",\"requests\":%lld,\"rps\":%.1f,\"seconds\":%.1f}\n",
+                phase, static_cast<long long>(total), static_cast<double>(total) / seconds, seconds);
+    std::fflush(stdout);
+}
+
+void parseArgs(int argc, char **argv) {
+    bench::Args args(argc, argv,
+                     "[--url URL] [--users N] [--family-size N] [--threads N]\n"
+                     "          [--duration-sec N] [--think-ms N] [--timeout-sec N] [--run-id ID]");
+    while (args.next()) {
+        if (args.is("--url")) {
+            gOptions.url = args.value();
+        } else if (args.is("--users")) {
+            gOptions.users = args.intValue(1);
+        } else if (args.is("--family-size")) {
+            gOptions.familySize = args.intValue(1);
+        } else if (args.is("--threads")) {
+            gOptions.threads = args.intValue(1);
+        } else if (args.is("--duration-sec")) {
+            gOptions.durationSec = args.intValue(1);
+        } else if (args.is("--think-ms")) {
+            gOptions.thinkMs = args.intValue(0);
+        } else if (args.is("--timeout-sec")) {
+            gOptions.timeoutSec = args.doubleValue(0);
+        } else if (args.is("--run-id")) {
+            gOptions.runId = args.value();
+        } else {
+            args.usage();
+        }
+    }
+    if (gOptions.runId.empty()) {
+        gOptions.runId = bench::defaultRunId();
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    parseArgs(argc, argv);
+
+    trantor::EventLoopThreadPool pool(static_cast<size_t>(gOptions.threads), "load");
+    pool.start();
+    std::vector<Worker> workers(static_cast<size_t>(gOptions.threads));
+    for (auto &w : workers) {
+        w.loop = pool.getNextLoop();
+        w.client = drogon::HttpClient::newHttpClient(gOptions.url, w.loop);
+    }
+
+    std::vector<User> users(static_cast<size_t>(gOptions.users));
+    for (int i = 0; i < gOptions.users; ++i) {
+        auto &user = users[i];
+        user.index = i;
+        user.worker = &workers[i % workers.size()];
+        user.email = "load-" + gOptions.runId + "-" + std::to_string(i) + "@example.com";
+        user.password = "load-password-" + std::to_string(i);
+    }
+
+    auto start = Clock::now();
+    runPhase(users, [](const User &) { return true; }, setupUser);
+    runPhase(users,
+             [](const User &u) { return gOptions.familySize > 1 && u.index % gOptions.familySize == 0; },
+             [&users](User &owner) { return setupFamily(owner, users); });
+    report("setup", workers, std::chrono::duration<double>(Clock::now() - start).count());
+
+    const auto ready = std::count_if(users.begin(), users.end(), [](const User &u) { return u.ready; });
+    if (ready == 0) {
+        std::fprintf(stderr,
+                     "No user finished setup: is the server up and started with --no-rate-limits?\n");
+        return 1;
+    }
+
+    start = Clock::now();
+    const auto until = start + std::chrono::seconds(gOptions.durationSec);
+    runPhase(users, [](const User &u) { return u.ready; },
+             [until](User &user) { return runUser(user, until); });
+    report("load", workers, std::chrono::duration<double>(Clock::now() - start).count());
+    return 0;
+}
@@ -0,0 +1,626 @@
+// Воспроизведение access.log плагина drogon::plugin::AccessLogger против
+// тестового экземпляра. Запросы отправляются с исходными интервалами между
+// ними (--speed N сжимает время в N раз) и без ожидания ответов, как
+// приходил реальный трафик. По каждому шаблону маршрута печатаются строкой
+// JSON задержки воспроизведения и записанное в журнале время обработки.
+//
+// Формат журнала — формат AccessLogger по умолчанию (log_format: ""):
+//   $request_date $method $url [$body_bytes_received] ($remote_addr - $local_addr)
+//   $status $body_bytes_sent $processing_time
+//
+// Журнал не содержит пользователей и тел запросов. Каждый адрес клиента
+// из журнала закрепляется за синтетическим пользователем (--users), который
+// заранее получает семью, личные и семейный счета, категории, бюджет и
+// транзакцию; id в путях заменяются на id его объектов, тела записей
+// генерируются. DELETE воспроизводится удалением строки, созданной прямо
+// перед ним (создание не попадает в статистику). Операции с составом семьи
+// (приглашение, вступление, выход) пропускаются и считаются отдельно.
+//
+// Как и для financial_manager_load, сервер запускается с ключом
+// --no-rate-limits (или с поднятыми лимитами finance::RateLimiter и
+// custom_config.login_throttle).
+#include "bench/BenchUtils.h"
+#include <trantor/net/EventLoopThreadPool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using drogon::HttpClientPtr;
+using drogon::HttpResponsePtr;
+using drogon::Task;
+using bench::Clock;
+using bench::isSuccess;
+using bench::jsonId;
+
+namespace {
+
+struct Options {
+    std::string log = "access.log";
+    std::string url = "http://127.0.0.1:9000";
+    double speed = 1.0;
+    int users = 50;
+    int threads = 4;
+    int64_t limit = 0;
+    double maxDurationSec = 0;
+    double timeoutSec = 10;
+    std::string runId;
+};
+
+Options gOptions;
+
+struct Entry {
+    int64_t atUs = 0;  // время запроса по журналу
+    drogon::HttpMethod method = drogon::Get;
+    std::string path;
+    std::string query;
+    std::string client;  // $remote_addr без порта
+    std::string route;   // шаблон маршрута: числовые сегменты заменены на {id}
+    double loggedMs = -1;
+};
+
+struct RouteStats : bench::RouteStats {
+    std::vector<double> loggedMs;
+    std::vector<double> lagMs;  // опоздание отправки относительно расписания
+
+    void merge(const RouteStats &other) {
+        bench::RouteStats::merge(other);
+        loggedMs.insert(loggedMs.end(), other.loggedMs.begin(), other.loggedMs.end());
+        lagMs.insert(lagMs.end(), other.lagMs.begin(), other.lagMs.end());
+    }
+};
+
+// Поток воспроизведения: свой loop и HTTP-клиент, статистика без блокировок
+struct Worker {
+    trantor::EventLoop *loop = nullptr;
+    HttpClientPtr client;
+    std::map<std::string, RouteStats> stats;
+    int64_t sequence = 0;
+};
+
+struct User {
+    int index = 0;
+    Worker *worker = nullptr;
+    std::string email;
+    std::string password;
+    std::string token;
+    int64_t card = 0;
+    int64_t cash = 0;
+    int64_t familyAccount = 0;
+    int64_t expenseCategory = 0;
+    int64_t familyCategory = 0;
+    int64_t budget = 0;
+    int64_t transaction = 0;
+    int64_t transfer = 0;
+    int64_t familyId = 0;
+    bool ready = false;
+};
+
+std::atomic<int64_t> gPending{0};
+std::atomic<int64_t> gSkipped{0};
+// Срок ожидания ответов истёк: запоздавшие ответы в статистику не пишутся,
+// такие запросы считаются в timed_out
+std::atomic<bool> gStopped{false};
+
+// ---- журнал ----
+
+drogon::HttpMethod parseMethod(const std::string &m, bool &ok) {
+    ok = true;
+    if (m == "GET") return drogon::Get;
+    if (m == "POST") return drogon::Post;
+    if (m == "PUT") return drogon::Put;
+    if (m == "DELETE") return drogon::Delete;
+    if (m == "PATCH") return drogon::Patch;
+    if (m == "HEAD") return drogon::Head;
+    ok = false;
+    return drogon::Get;
+}
+
+std::string routeOf(const std::string &path) {
+    std::string route;
+    size_t pos = 0;
+    while (pos < path.size()) {
+        const size_t next = std::min(path.find('/', pos + 1), path.size());
+        const std::string segment = path.substr(pos, next - pos);
+        const bool numeric = segment.size() > 1 &&
+                             std::all_of(segment.begin() + 1, segment.end(), ::isdigit);
+        route += numeric ? "/{id}" : segment;
+        pos = next;
+    }
+    return route.empty() ? "/" : route;
+}
+
+// "20240315 12:34:56.123456" -> микросекунды; часовой пояс не важен,
+// используются только разности
+int64_t parseDate(const std::string &date, const std::string &time) {
+    std::tm tm{};
+    if (date.size() != 8 || std::sscanf(time.c_str(), "%d:%d:%d", &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 3) {
+        return -1;
+    }
+    tm.tm_year = std::atoi(date.substr(0, 4).c_str()) - 1900;
+    tm.tm_mon = std::atoi(date.substr(4, 2).c_str()) - 1;
+    tm.tm_mday = std::atoi(date.substr(6, 2).c_str());
+    int64_t us = static_cast<int64_t>(timegm(&tm)) * 1000000;
+    const auto dot = time.find('.');
+    if (dot != std::string::npos) {
+        std::string frac = time.substr(dot + 1, 6);
+        frac.resize(6, '0');
+        us += std::atoll(frac.c_str());
+    }
+    return us;
+}
+
+std::vector<Entry> readLog(int64_t &rejected) {
+    static const std::regex line(
+        R"(^(\d{8}) (\d{2}:\d{2}:\d{2}(?:\.\d+)?) (\S+) (\S+) \[\d+\] \((\S+) - \S+\) (\d{3}) \d+ (\S+))");
+    std::ifstream in(gOptions.log);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + gOptions.log);
+    }
+    std::vector<Entry> entries;
+    std::string text;
+    std::smatch m;
+    rejected = 0;
+    while (std::getline(in, text)) {
+        bool methodOk = false;
+        Entry e;
+        if (!std::regex_search(text, m, line) ||
+            (e.atUs = parseDate(m[1], m[2])) < 0 ||
+            (e.method = parseMethod(m[3], methodOk), !methodOk)) {
+            ++rejected;
+            continue;
+        }
+        const std::string url = m[4];
+        const auto q = url.find('?');
+        e.path = url.substr(0, q);
+        e.query = q == std::string::npos ? "" : url.substr(q + 1);
+        e.client = m[5];
+        const auto colon = e.client.rfind(':');
+        if (colon != std::string::npos && e.client.find(']') == std::string::npos) {
+            e.client.resize(colon);
+        }
+        e.route = routeOf(e.path);
+        e.loggedMs = std::atof(m[7].str().c_str()) * 1000;
+        entries.push_back(std::move(e));
+        if (gOptions.limit > 0 && static_cast<int64_t>(entries.size()) >= gOptions.limit) {
+            break;
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry &a, const Entry &b) { return a.atUs < b.atUs; });
+    return entries;
+}
+
+// ---- HTTP ----
+
+// Запрос в loop потока; при stats ответ записывается в статистику маршрута,
+// при retryThrottled ответы 429/503 повторяются после Retry-After
+Task<HttpResponsePtr> send(Worker &w,
+                           drogon::HttpMethod method,
+                           const std::string &path,
+                           const std::string &query,
+                           const Json::Value *body,
+                           const std::string &token,
+                           RouteStats *stats = nullptr,
+                           bool retryThrottled = false) {
+    bench::Observer observe;
+    if (stats) {
+        observe = [stats](const HttpResponsePtr &resp, double ms) {
+            if (!gStopped.load()) {
+                stats->record(resp, ms);
+            }
+        };
+    }
+    return bench::send(w.client, w.loop, {method, query.empty() ? path : path + "?" + query, body, token},
+                       gOptions.timeoutSec, retryThrottled ? bench::Retry{20} : bench::Retry{},
+                       std::move(observe));
+}
+
+bool isFamilyQuery(const std::string &query) {
+    return query.find("family=true") != std::string::npos;
+}
+
+// ---- синтетические пользователи ----
+
+Task<int64_t> createAccount(User &u, const char *name, bool family) {
+    Json::Value body;
+    body["account_name"] = name;
+    body["account_type"] = "card";
+    body["balance"] = "1000000.00";
+    co_return jsonId(co_await send(*u.worker, drogon::Post, "/accounts", family ? "family=true" : "",
+                                   &body, u.token, nullptr, true));
+}
+
+Task<int64_t> createCategory(User &u, const char *name, bool family) {
+    Json::Value body;
+    body["name"] = name;
+    body["type"] = "expense";
+    co_return jsonId(co_await send(*u.worker, drogon::Post, "/categories", family ? "family=true" : "",
+                                   &body, u.token, nullptr, true));
+}
+
+Json::Value transactionBody(const User &u, bool family) {
+    Json::Value body;
+    body["id_account"] = static_cast<Json::Int64>(family ? u.familyAccount : u.cash);
+    body["id_category"] = static_cast<Json::Int64>(family ? u.familyCategory : u.expenseCategory);
+    body["amount"] = "1.00";
+    body["type"] = "expense";
+    body["description"] = "replay";
+    return body;
+}
+
+Json::Value transferBody(const User &u) {
+    Json::Value body;
+    body["account_from"] = static_cast<Json::Int64>(u.card);
+    body["account_to"] = static_cast<Json::Int64>(u.cash);
+    body["amount"] = "1.00";
+    return body;
+}
+
+Json::Value budgetBody(const User &u) {
+    Json::Value body;
+    body["id_category"] = static_cast<Json::Int64>(u.expenseCategory);
+    body["month"] = 1;
+    body["year"] = 2030;
+    body["limit_amount"] = "500.00";
+    return body;
+}
+
+// Регистрация, вход, семья из одного человека и объекты для подстановки id
+Task<> setupUser(User &u) {
+    auto &w = *u.worker;
+    Json::Value reg;
+    reg["name"] = "Replay user " + std::to_string(u.index);
+    reg["email"] = u.email;
+    reg["password"] = u.password;
+    auto resp = co_await send(w, drogon::Post, "/api/auth/register", "", &reg, "", nullptr, true);
+    if (!isSuccess(resp) || !resp->getJsonObject()) {
+        co_return;
+    }
+    u.token = (*resp->getJsonObject())["token"].asString();
+
+    Json::Value family;
+    family["name"] = "Replay family " + std::to_string(u.index);
+    u.familyId = jsonId(co_await send(w, drogon::Post, "/api/family", "", &family, u.token, nullptr, true));
+
+    u.card = co_await createAccount(u, "Replay card", false);
+    u.cash = co_await createAccount(u, "Replay cash", false);
+    u.familyAccount = co_await createAccount(u, "Replay family", true);
+    u.expenseCategory = co_await createCategory(u, "Replay groceries", false);
+    u.familyCategory = co_await createCategory(u, "Replay family groceries", true);
+
+    auto budget = budgetBody(u);
+    u.budget = jsonId(co_await send(w, drogon::Post, "/budgets", "", &budget, u.token, nullptr, true));
+    auto tx = transactionBody(u, false);
+    u.transaction = jsonId(co_await send(w, drogon::Post, "/transactions", "", &tx, u.token, nullptr, true));
+    auto tr = transferBody(u);
+    u.transfer = jsonId(co_await send(w, drogon::Post, "/transfers", "", &tr, u.token, nullptr, true));
+
+    u.ready = u.familyId && u.card && u.cash && u.familyAccount && u.expenseCategory &&
+              u.familyCategory && u.budget && u.transaction && u.transfer;
+}
+
+// ---- воспроизведение ----
+
+// Путь с id объектов пользователя вместо id из журнала
+std::string substitute(const User &u, const std::string &route, bool family) {
+    auto with = [](const char *prefix, int64_t id) { return prefix + std::to_string(id); };
+    if (route == "/accounts/{id}") return with("/accounts/", family ? u.familyAccount : u.card);
+    if (route == "/transactions/{id}") return with("/transactions/", u.transaction);
+    if (route == "/transfers/{id}") return with("/transfers/", u.transfer);
+    if (route == "/budgets/{id}") return with("/budgets/", u.budget);
+    if (route == "/categories/{id}") return with("/categories/", u.expenseCategory);
+    if (route == "/api/family/{id}/members") return with("/api/family/", u.familyId) + "/members";
+    return route;
+}
+
+// Строка, которую воспроизводимый DELETE может удалить
+Task<std::string> createForDelete(User &u, const std::string &route, bool family) {
+    auto &w = *u.worker;
+    const std::string query = family ? "family=true" : "";
+    Json::Value body;
+    std::string collection;
+    if (route == "/transactions/{id}") {
+        body = transactionBody(u, family);
+        collection = "/transactions";
+    } else if (route == "/transfers/{id}") {
+        body = transferBody(u);
+        collection = "/transfers";
+    } else if (route == "/budgets/{id}") {
+        body = budgetBody(u);
+        collection = "/budgets";
+    } else if (route == "/categories/{id}") {
+        body["name"] = "Replay delete " + std::to_string(++w.sequence);
+        body["type"] = "expense";
+        collection = "/categories";
+    } else if (route == "/accounts/{id}") {
+        body["account_name"] = "Replay delete";
+        body["account_type"] = "cash";
+        collection = "/accounts";
+    } else {
+        co_return "";
+    }
+    const int64_t id = jsonId(co_await send(w, drogon::Post, collection, query, &body, u.token));
+    co_return id ? collection + "/" + std::to_string(id) : "";
+}
+
+Task<> replay(User &u, const Entry &e, double lagMs) {
+    auto &w = *u.worker;
+    auto &stats = w.stats[std::string(drogon::to_string_view(e.method)) + " " + e.route];
+    stats.lagMs.push_back(lagMs);
+    if (e.loggedMs >= 0) {
+        stats.loggedMs.push_back(e.loggedMs);
+    }
+    const bool family = isFamilyQuery(e.query);
+
+    if (e.method == drogon::Get || e.method == drogon::Head) {
+        co_await send(w, e.method, substitute(u, e.route, family), e.query, nullptr, u.token, &stats);
+        co_return;
+    }
+    if (e.route == "/api/auth/login") {
+        Json::Value body;
+        body["email"] = u.email;
+        body["password"] = u.password;
+        co_await send(w, drogon::Post, e.route, "", &body, "", &stats);
+        co_return;
+    }
+    if (e.route == "/api/auth/register") {
+        Json::Value body;
+        body["name"] = "Replay signup";
+        body["email"] = "replay-" + gOptions.runId + "-" + std::to_string(u.index) + "-" +
+                        std::to_string(++w.sequence) + "@example.com";
+        body["password"] = "replay-password";
+        co_await send(w, drogon::Post, e.route, "", &body, "", &stats);
+        co_return;
+    }
+    if (e.method == drogon::Delete && e.route != "/api/auth/account" &&
+        e.route.rfind("/api/family", 0) != 0) {
+        const std::string path = co_await createForDelete(u, e.route, family);
+        if (path.empty()) {
+            ++gSkipped;
+            co_return;
+        }
+        co_await send(w, drogon::Delete, path, e.query, nullptr, u.token, &stats);
+        co_return;
+    }
+
+    Json::Value body;
+    if (e.route == "/transactions" || e.route == "/transactions/{id}") {
+        body = transactionBody(u, family && e.method == drogon::Post);
+    } else if (e.route == "/transfers" || e.route == "/transfers/{id}") {
+        body = transferBody(u);
+    } else if (e.route == "/budgets" || e.route == "/budgets/{id}") {
+        body = budgetBody(u);
+        if (e.method == drogon::Post) {
+            body["month"] = static_cast<int>(1 + w.sequence++ % 12);
+        }
+    } else if (e.route == "/categories" || e.route == "/categories/{id}") {
+        body["name"] = "Replay category " + std::to_string(++w.sequence);
+        body["type"] = "expense";
+    } else if (e.route == "/accounts" || e.route == "/accounts/{id}") {
+        body["account_name"] = "Replay account";
+        body["account_type"] = "cash";
+    } else if (e.route == "/api/auth/profile") {
+        body["name"] = "Replay user " + std::to_string(u.index);
+    } else {
+        // Состав семьи, удаление пользователя и прочее меняют то, на что
+        // опираются следующие запросы
+        ++gSkipped;
+        co_return;
+    }
+    // Семейными воспроизводятся только создания транзакций и счетов,
+    // остальные записи идут по личным объектам пользователя
+    const bool keepScope = e.method == drogon::Post && (e.route == "/transactions" || e.route == "/accounts");
+    const std::string query = keepScope ? e.query : "";
+    co_await send(w, e.method, substitute(u, e.route, false), query, &body, u.token, &stats);
+}
+
+// Запускает fn для каждого пользователя в loop его потока и ждёт всех
+void runSetup(std::vector<User> &users) {
+    auto pending = std::make_shared<std::atomic<int>>(static_cast<int>(users.size()));
+    auto done = std::make_shared<std::promise<void>>();
+    auto finished = done->get_future();
+    for (auto &user : users) {
+        User *u = &user;
+        u->worker->loop->queueInLoop([u, pending, done]() {
+            drogon::async_run([u, pending, done]() -> Task<> {
+                try {
+                    co_await setupUser(*u);
+                } catch (const std::exception &e) {
+                    std::fprintf(stderr, "user %d: %s\n", u->index, e.what());
+                }
+                if (pending->fetch_sub(1) == 1) {
+                    done->set_value();
+                }
+            });
+        });
+    }
+    finished.wait();
+}
+
+void report(std::vector<Worker> &workers,
+            double seconds,
+            int64_t entries,
+            int64_t rejected,
+            int64_t timedOut) {
+    std::map<std::string, RouteStats> merged;
+    for (auto &w : workers) {
+        for (auto &[route, stats] : w.stats) {
+            merged[route].merge(stats);
+        }
+    }
+    for (auto &[route, s] : merged) {
+        for (auto *values : {&s.latenciesMs, &s.loggedMs, &s.lagMs}) {
+            std::sort(values->begin(), values->end());
+        }
+        const int64_t count = s.requests();
+        std::printf("{\"route\":\"%s\",\"requests\":%lld,\"rps\":%.1f,\"ok\":%lld,\"4xx\":%lld,"
+                    "\"5xx\":%lld,\"network_errors\":%lld,\"p50_ms\":%.2f,\"p95_ms\":%.2f,"
+                    "\"p99_ms\":%.2f,\"max_ms\":%.2f,\"logged_p50_ms\":%.2f,\"logged_p99_ms\":%.2f,"
+                    "\"lag_p99_ms\":%.2f}\n",
+                    route.c_str(), static_cast<long long>(count), static_cast<double>(count) / seconds,
+                    static_cast<long long>(s.ok), static_cast<long long>(s.clientErrors),
+                    static_cast<long long>(s.serverErrors), static_cast<long long>(s.networkErrors),
+                    bench::percentile(s.latenciesMs, 0.50), bench::percentile(s.latenciesMs, 0.95),
+                    bench::percentile(s.latenciesMs, 0.99), bench::percentile(s.latenciesMs, 1.0),
+                    bench::percentile(s.loggedMs, 0.50), bench::percentile(s.loggedMs, 0.99),
+                    bench::percentile(s.lagMs, 0.99));
+    }
+    std::printf("{\"route\":\"*\",\"entries\":%lld,\"rejected_lines\":%lld,\"skipped\":%lld,"
+                "\"timed_out\":%lld,\"seconds\":%.1f,\"speed\":%.2f}\n",
+                static_cast<long long>(entries), static_cast<long long>(rejected),
+                static_cast<long long>(gSkipped.load()), static_cast<long long>(timedOut),
+                seconds, gOptions.speed);
+    std::fflush(stdout);
+}
+
+void parseArgs(int argc, char **argv) {
+    bench::Args args(argc, argv,
+                     "[--log PATH] [--url URL] [--speed N] [--users N] [--threads N]\n"
+                     "          [--limit N] [--max-duration-sec N] [--timeout-sec N] [--run-id ID]");
+    while (args.next()) {
+        if (args.is("--log")) {
+            gOptions.log = args.value();
+        } else if (args.is("--url")) {
+            gOptions.url = args.value();
+        } else if (args.is("--speed")) {
+            gOptions.speed = args.doubleValue(0.01);
+        } else if (args.is("--users")) {
+            gOptions.users = args.intValue(1);
+        } else if (args.is("--threads")) {
+            gOptions.threads = args.intValue(1);
+        } else if (args.is("--limit")) {
+            gOptions.limit = args.int64Value(0);
+        } else if (args.is("--max-duration-sec")) {
+            gOptions.maxDurationSec = args.doubleValue(0);
+        } else if (args.is("--timeout-sec")) {
+            gOptions.timeoutSec = args.doubleValue(0);
+        } else if (args.is("--run-id")) {
+            gOptions.runId = args.value();
+        } else {
+            args.usage();
+        }
+    }
+    if (gOptions.runId.empty()) {
+        gOptions.runId = bench::defaultRunId();
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    parseArgs(argc, argv);
+
+    int64_t rejected = 0;
+    std::vector<Entry> entries;
+    try {
+        entries = readLog(rejected);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    if (entries.empty()) {
+        std::fprintf(stderr, "No requests in %s (%lld lines not recognised)\n", gOptions.log.c_str(),
+                     static_cast<long long>(rejected));
+        return 1;
+    }
+
+    trantor::EventLoopThreadPool pool(static_cast<size_t>(gOptions.threads), "replay");
+    pool.start();
+    std::vector<Worker> workers(static_cast<size_t>(gOptions.threads));
+    for (auto &w : workers) {
+        w.loop = pool.getNextLoop();
+        w.client = drogon::HttpClient::newHttpClient(gOptions.url, w.loop);
+    }
+
+    std::vector<User> users(static_cast<size_t>(gOptions.users));
+    for (int i = 0; i < gOptions.users; ++i) {
+        auto &u = users[static_cast<size_t>(i)];
+        u.index = i;
+        u.worker = &workers[static_cast<size_t>(i) % workers.size()];
+        u.email = "replay-" + gOptions.runId + "-" + std::to_string(i) + "@example.com";
+        u.password = "replay-password-" + std::to_string(i);
+    }
+    runSetup(users);
+    std::vector<User *> ready;
+    for (auto &u : users) {
+        if (u.ready) {
+            ready.push_back(&u);
+        }
+    }
+    if (ready.empty()) {
+        std::fprintf(stderr,
+                     "No user finished setup: is the server up and started with --no-rate-limits?\n");
+        return 1;
+    }
+
+    // Клиенты журнала закрепляются за пользователями по порядку появления
+    std::unordered_map<std::string, User *> byClient;
+    const auto start = Clock::now() + std::chrono::milliseconds(200);
+    const int64_t firstUs = entries.front().atUs;
+    int64_t dispatched = 0;
+    for (const auto &e : entries) {
+        const auto offset = std::chrono::duration<double, std::micro>(
+            static_cast<double>(e.atUs - firstUs) / gOptions.speed);
+        const auto due = start + std::chrono::duration_cast<Clock::duration>(offset);
+        if (gOptions.maxDurationSec > 0 &&
+            std::chrono::duration<double>(due - start).count() > gOptions.maxDurationSec) {
+            break;
+        }
+        auto [it, inserted] = byClient.try_emplace(e.client, nullptr);
+        if (inserted) {
+            it->second = ready[byClient.size() % ready.size()];
+        }
+        User *u = it->second;
+
+        std::this_thread::sleep_until(due);
+        const double lagMs = std::chrono::duration<double, std::milli>(Clock::now() - due).count();
+        ++gPending;
+        ++dispatched;
+        u->worker->loop->queueInLoop([u, &e, lagMs]() {
+            drogon::async_run([u, &e, lagMs]() -> Task<> {
+                try {
+                    co_await replay(*u, e, lagMs);
+                } catch (const std::exception &ex) {
+                    std::fprintf(stderr, "%s %s: %s\n", e.route.c_str(), e.path.c_str(), ex.what());
+                }
+                --gPending;
+            });
+        });
+    }
+
+    // Ответы на последние запросы
+    const auto drainUntil = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                               std::chrono::duration<double>(gOptions.timeoutSec * 2));
+    while (gPending.load() > 0 && Clock::now() < drainUntil) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Статистику пишут только корутины в loop потоков. После gStopped и
+    // прохода через каждый loop запоздавшие ответы её уже не трогают, и
+    // главный поток читает её без гонки.
+    gStopped = true;
+    const int64_t timedOut = gPending.load();
+    for (auto &w : workers) {
+        std::promise<void> synced;
+        w.loop->queueInLoop([&synced]() { synced.set_value(); });
+        synced.get_future().wait();
+    }
+    report(workers, seconds, dispatched, rejected, timedOut);
+    return 0;
+}
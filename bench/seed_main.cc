@@ -0,0 +1,612 @@
+// Генератор синтетических данных для нагрузочных замеров. Загружает через
+// COPY пользователей, семьи, счета, категории, бюджеты и историю операций
+// с правдоподобным распределением дат и сумм. Балансы счетов равны сумме
+// проведённых по ним транзакций и переводов и ни в какой момент не уходят
+// в минус: недостающие средства приходят пополнением перед списанием, сверх
+// --transactions-per-user. Семейные счета пополняются и расходуются только по
+// семейным категориям, переводы идут только между личными счетами.
+//
+// Всё выполняется одной транзакцией под блокировкой таблиц, id новых строк
+// продолжают текущие последовательности. Пароль у всех пользователей общий
+// (--password), email вида seed<id>@example.com.
+//
+// Пример:
+//   ./financial_manager_seed --config ../config.json --users 10000
+//       --transactions-per-user 500 --transfers-per-user 20
+#include <libpq-fe.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "db/DbConfig.h"
+#include "utils/PasswordUtils.h"
+
+namespace {
+
+struct Options {
+    std::string configPath = "../config.json";
+    std::string client = "default";
+    int64_t users = 1000;
+    int familySize = 4;
+    int accountsPerUser = 3;
+    int64_t transactionsPerUser = 1000;
+    int64_t transfersPerUser = 50;
+    int months = 24;
+    uint64_t seed = 42;
+    std::string password = "seed-password";
+};
+
+Options gOptions;
+
+const std::array<const char *, 3> kAccountTypes{"card", "cash", "deposit"};
+const char *kIncomeCategory = "Зарплата";
+// Пополнение счёта, которому не хватает средств на следующий расход
+const char *kTopUpCategory = "Пополнение";
+const std::array<const char *, 6> kExpenseCategories{
+    "Продукты", "Транспорт", "Кафе и рестораны", "Коммунальные платежи", "Здоровье", "Развлечения"};
+// Доли расходов по категориям (в сумме 1) и медианы сумм в рублях
+const std::array<double, 6> kExpenseShare{0.38, 0.18, 0.16, 0.06, 0.10, 0.12};
+const std::array<double, 6> kExpenseMedian{900, 250, 1200, 4500, 1500, 2000};
+// Время суток покупок: веса по часам 0..23
+const std::array<double, 24> kHourWeight{
+    1, 0.5, 0.3, 0.2, 0.2, 0.4, 1, 3, 5, 5, 6, 7, 9, 9, 7, 6, 6, 8, 10, 10, 8, 5, 3, 2};
+
+// Категории пользователя: 0 — зарплата, 1..N — расходы, N + 1 — пополнение.
+// У члена семьи последняя категория расходов и пополнение — семейные.
+constexpr int kFamilyExpenseCategory = static_cast<int>(kExpenseCategories.size());
+constexpr int kTopUpCategoryIndex = kFamilyExpenseCategory + 1;
+constexpr int kCategoriesPerUser = kTopUpCategoryIndex + 1;
+constexpr int64_t kDaySec = 24 * 3600;
+
+// ---- libpq ----
+
+struct PgResult {
+    explicit PgResult(PGresult *r) : res(r) {}
+    ~PgResult() { PQclear(res); }
+    PgResult(const PgResult &) = delete;
+    PgResult &operator=(const PgResult &) = delete;
+    PGresult *res;
+};
+
+void exec(PGconn *conn, const std::string &sql) {
+    PgResult r(PQexec(conn, sql.c_str()));
+    const auto status = PQresultStatus(r.res);
+    if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK) {
+        throw std::runtime_error(sql + ": " + PQerrorMessage(conn));
+    }
+}
+
+int64_t queryInt(PGconn *conn, const std::string &sql) {
+    PgResult r(PQexec(conn, sql.c_str()));
+    if (PQresultStatus(r.res) != PGRES_TUPLES_OK || PQntuples(r.res) != 1) {
+        throw std::runtime_error(sql + ": " + PQerrorMessage(conn));
+    }
+    return std::atoll(PQgetvalue(r.res, 0, 0));
+}
+
+// Поток COPY ... FROM STDIN в текстовом формате; строки копятся в буфере
+// и отправляются пачками
+class CopyStream {
+public:
+    CopyStream(PGconn *conn, const std::string &table, const std::string &columns)
+        : conn_(conn), table_(table) {
+        PgResult r(PQexec(conn, ("COPY " + table + " (" + columns + ") FROM STDIN").c_str()));
+        if (PQresultStatus(r.res) != PGRES_COPY_IN) {
+            throw std::runtime_error("COPY " + table + ": " + PQerrorMessage(conn));
+        }
+        buffer_.reserve(kFlushBytes + 4096);
+    }
+
+    // Поля через табуляцию; значения не содержат табуляций и переводов строк
+    template <typename... Fields>
+    void row(const Fields &...fields) {
+        bool first = true;
+        ((append(fields, first)), ...);
+        buffer_ += '\n';
+        ++rows_;
+        if (buffer_.size() >= kFlushBytes) {
+            flush();
+        }
+    }
+
+    int64_t finish() {
+        flush();
+        if (PQputCopyEnd(conn_, nullptr) != 1) {
+            throw std::runtime_error("COPY " + table_ + " end: " + PQerrorMessage(conn_));
+        }
+        while (PGresult *res = PQgetResult(conn_)) {
+            PgResult r(res);
+            if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+                throw std::runtime_error("COPY " + table_ + ": " + PQerrorMessage(conn_));
+            }
+        }
+        return rows_;
+    }
+
+private:
+    static constexpr size_t kFlushBytes = 1 << 20;
+
+    void append(const std::string &value, bool &first) {
+        separator(first);
+        buffer_ += value;
+    }
+    void append(const char *value, bool &first) {
+        separator(first);
+        buffer_ += value ? value : "\\N";
+    }
+    void append(int64_t value, bool &first) {
+        separator(first);
+        buffer_ += std::to_string(value);
+    }
+    void append(int value, bool &first) { append(static_cast<int64_t>(value), first); }
+    void append(bool value, bool &first) {
+        separator(first);
+        buffer_ += value ? 't' : 'f';
+    }
+    void separator(bool &first) {
+        if (!first) {
+            buffer_ += '\t';
+        }
+        first = false;
+    }
+
+    void flush() {
+        if (buffer_.empty()) {
+            return;
+        }
+        if (PQputCopyData(conn_, buffer_.data(), static_cast<int>(buffer_.size())) != 1) {
+            throw std::runtime_error("COPY " + table_ + ": " + PQerrorMessage(conn_));
+        }
+        buffer_.clear();
+    }
+
+    PGconn *conn_;
+    std::string table_;
+    std::string buffer_;
+    int64_t rows_ = 0;
+};
+
+// ---- генерация ----
+
+std::string money(int64_t cents) {
+    const char *sign = cents < 0 ? "-" : "";
+    const int64_t abs = std::llabs(cents);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%s%lld.%02lld", sign, static_cast<long long>(abs / 100),
+                  static_cast<long long>(abs % 100));
+    return buf;
+}
+
+std::string timestamp(int64_t epochSec) {
+    std::time_t t = static_cast<std::time_t>(epochSec);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+// Первый id новых строк каждой таблицы (после текущего максимума)
+struct IdBase {
+    int64_t user = 0;
+    int64_t family = 0;
+    int64_t account = 0;
+    int64_t category = 0;
+};
+
+IdBase gBase;
+int64_t gNow = 0;
+int64_t gWindowStart = 0;
+
+int64_t userId(int64_t u) { return gBase.user + u + 1; }
+int64_t accountId(int64_t u, int a) { return gBase.account + u * gOptions.accountsPerUser + a + 1; }
+int64_t categoryId(int64_t u, int c) { return gBase.category + u * kCategoriesPerUser + c + 1; }
+
+bool inFamily(int64_t u) {
+    if (gOptions.familySize < 2) {
+        return false;
+    }
+    // Последняя неполная группа остаётся без семьи
+    return (u / gOptions.familySize + 1) * gOptions.familySize <= gOptions.users;
+}
+
+// Последний счёт, последняя категория расходов и пополнение члена семьи — семейные
+bool familyAccount(int64_t u, int a) {
+    return inFamily(u) && gOptions.accountsPerUser > 1 && a == gOptions.accountsPerUser - 1;
+}
+bool familyCategory(int64_t u, int c) {
+    return inFamily(u) && (c == kFamilyExpenseCategory || c == kTopUpCategoryIndex);
+}
+
+bool incomeCategory(int c) { return c == 0 || c == kTopUpCategoryIndex; }
+
+const char *categoryName(int c) {
+    if (c == 0) {
+        return kIncomeCategory;
+    }
+    if (c == kTopUpCategoryIndex) {
+        return kTopUpCategory;
+    }
+    return kExpenseCategories[static_cast<size_t>(c - 1)];
+}
+
+struct Entry {
+    bool transfer = false;
+    int account = 0;    // счёт транзакции или счёт-источник перевода
+    int accountTo = 0;  // счёт-получатель перевода
+    int category = 0;
+    bool income = false;
+    int64_t cents = 0;
+    int64_t at = 0;
+};
+
+// Операции пользователя u по времени. Генератор детерминирован (seed и номер
+// пользователя), поэтому повторный вызов даёт те же операции: первый проход
+// считает балансы, следующие пишут строки.
+std::vector<Entry> ledger(int64_t u) {
+    std::mt19937_64 rng(gOptions.seed * 1000003ULL + static_cast<uint64_t>(u));
+    std::vector<Entry> out;
+    out.reserve(static_cast<size_t>(gOptions.transactionsPerUser + gOptions.transfersPerUser));
+
+    // Семейная категория расходов члена семьи идёт только на семейный счёт
+    std::array<double, kExpenseShare.size()> personalShare = kExpenseShare;
+    if (inFamily(u)) {
+        personalShare.back() = 0;
+    }
+    std::discrete_distribution<int> hourDist(kHourWeight.begin(), kHourWeight.end());
+    std::discrete_distribution<int> categoryDist(personalShare.begin(), personalShare.end());
+    std::uniform_int_distribution<int64_t> dayDist(0, (gNow - gWindowStart) / kDaySec - 1);
+    std::uniform_int_distribution<int64_t> secDist(0, 3599);
+    std::normal_distribution<double> salaryDist(0, 0.08);
+    std::normal_distribution<double> amountNoise(0, 0.9);
+    const double salary = 60000 * std::exp(std::normal_distribution<double>(0, 0.4)(rng));
+
+    auto timeOfDay = [&](int64_t dayStart) {
+        return dayStart + hourDist(rng) * 3600 + secDist(rng);
+    };
+
+    // Зарплата раз в месяц в первые дни месяца на основной счёт
+    const int64_t incomes = std::min<int64_t>(gOptions.months, gOptions.transactionsPerUser);
+    for (int64_t m = 0; m < incomes; ++m) {
+        Entry e;
+        e.income = true;
+        e.account = 0;
+        e.category = 0;
+        e.cents = std::llround(salary * (1 + salaryDist(rng)) * 100);
+        e.at = std::min(gNow - 1, gWindowStart + m * 30 * kDaySec +
+                                      static_cast<int64_t>(rng() % 5) * kDaySec + 10 * 3600);
+        out.push_back(e);
+    }
+
+    // Расходы: логнормальные суммы вокруг медианы категории, случайный день.
+    // Категория в области счёта: с семейного счёта — семейная.
+    for (int64_t i = incomes; i < gOptions.transactionsPerUser; ++i) {
+        Entry e;
+        e.account = static_cast<int>(rng() % static_cast<uint64_t>(gOptions.accountsPerUser));
+        const int c = familyAccount(u, e.account) ? kFamilyExpenseCategory - 1 : categoryDist(rng);
+        e.category = 1 + c;
+        e.cents = std::max<int64_t>(
+            100, std::llround(kExpenseMedian[c] * std::exp(amountNoise(rng)) * 100));
+        e.at = timeOfDay(gWindowStart + dayDist(rng) * kDaySec);
+        out.push_back(e);
+    }
+
+    // Переводы между своими личными счетами: в основном с основного на
+    // остальные. Семейный счёт в переводах не участвует.
+    const int personalAccounts =
+        gOptions.accountsPerUser - (familyAccount(u, gOptions.accountsPerUser - 1) ? 1 : 0);
+    if (personalAccounts > 1) {
+        std::uniform_int_distribution<int> otherDist(1, personalAccounts - 1);
+        for (int64_t i = 0; i < gOptions.transfersPerUser; ++i) {
+            Entry e;
+            e.transfer = true;
+            const int other = otherDist(rng);
+            const bool fromMain = rng() % 4 != 0;
+            e.account = fromMain ? 0 : other;
+            e.accountTo = fromMain ? other : 0;
+            e.cents = std::llround(5000 * std::exp(amountNoise(rng)) * 100);
+            e.at = timeOfDay(gWindowStart + dayDist(rng) * kDaySec);
+            out.push_back(e);
+        }
+    }
+
+    // Проводим операции по времени. Если списание увело бы счёт в минус,
+    // перед ним добавляется пополнение этого счёта, кратное 5000 рублей.
+    std::stable_sort(out.begin(), out.end(),
+                     [](const Entry &a, const Entry &b) { return a.at < b.at; });
+    std::vector<int64_t> balance(static_cast<size_t>(gOptions.accountsPerUser), 0);
+    std::vector<Entry> funded;
+    funded.reserve(out.size() + out.size() / 4);
+    for (const auto &e : out) {
+        auto &from = balance[static_cast<size_t>(e.account)];
+        if (!e.income && from < e.cents) {
+            constexpr int64_t kTopUpStep = 5000 * 100;
+            Entry topUp;
+            topUp.income = true;
+            topUp.account = e.account;
+            // Пополнение у члена семьи семейное, поэтому его личные счета
+            // пополняются зарплатой
+            topUp.category = familyAccount(u, e.account) || !inFamily(u) ? kTopUpCategoryIndex : 0;
+            topUp.cents = (e.cents - from + kTopUpStep - 1) / kTopUpStep * kTopUpStep;
+            topUp.at = e.at - 600;
+            from += topUp.cents;
+            funded.push_back(topUp);
+        }
+        if (e.transfer) {
+            from -= e.cents;
+            balance[static_cast<size_t>(e.accountTo)] += e.cents;
+        } else {
+            from += e.income ? e.cents : -e.cents;
+        }
+        funded.push_back(e);
+    }
+    return funded;
+}
+
+void progress(const char *stage, int64_t done, int64_t total) {
+    if (done % 1000 == 0 || done == total) {
+        std::fprintf(stderr, "\r%s: %lld/%lld", stage, static_cast<long long>(done),
+                     static_cast<long long>(total));
+        if (done == total) {
+            std::fprintf(stderr, "\n");
+        }
+    }
+}
+
+void seed(PGconn *conn) {
+    // statement_timeout из connect_options клиента не должен прерывать COPY
+    exec(conn, "SET statement_timeout = 0");
+    exec(conn, "BEGIN");
+    exec(conn, "LOCK TABLE users, families, family_members, account, category, budgets, "
+               "transactions, transfer IN EXCLUSIVE MODE");
+    gBase.user = queryInt(conn, "SELECT COALESCE(MAX(id), 0) FROM users");
+    gBase.family = queryInt(conn, "SELECT COALESCE(MAX(id), 0) FROM families");
+    gBase.account = queryInt(conn, "SELECT COALESCE(MAX(id), 0) FROM account");
+    gBase.category = queryInt(conn, "SELECT COALESCE(MAX(id), 0) FROM category");
+
+    const std::string hash = security::hashPassword(gOptions.password);
+    const int64_t users = gOptions.users;
+    const int accounts = gOptions.accountsPerUser;
+    const std::string created = timestamp(gWindowStart - 30 * kDaySec);
+
+    // Проход 1: балансы по всему журналу
+    std::vector<int64_t> balances(static_cast<size_t>(users * accounts), 0);
+    for (int64_t u = 0; u < users; ++u) {
+        for (const auto &e : ledger(u)) {
+            auto &from = balances[static_cast<size_t>(u * accounts + e.account)];
+            if (e.transfer) {
+                from -= e.cents;
+                balances[static_cast<size_t>(u * accounts + e.accountTo)] += e.cents;
+            } else {
+                from += e.income ? e.cents : -e.cents;
+            }
+        }
+        progress("ledger", u + 1, users);
+    }
+
+    {
+        CopyStream copy(conn, "users", "id, name, email, hashed_password, created_at");
+        for (int64_t u = 0; u < users; ++u) {
+            copy.row(userId(u), "Пользователь " + std::to_string(userId(u)),
+                     "seed" + std::to_string(userId(u)) + "@example.com", hash, created);
+        }
+        copy.finish();
+    }
+
+    int64_t families = 0;
+    if (gOptions.familySize > 1) {
+        CopyStream famCopy(conn, "families", "id, name, id_owner, created_at");
+        for (int64_t u = 0; u < users; u += gOptions.familySize) {
+            if (!inFamily(u)) {
+                break;
+            }
+            ++families;
+            famCopy.row(gBase.family + families, "Семья " + std::to_string(gBase.family + families),
+                        userId(u), created);
+        }
+        famCopy.finish();
+
+        CopyStream memberCopy(conn, "family_members", "id_family, id_user, joined_at");
+        for (int64_t u = 0; u < users && inFamily(u); ++u) {
+            memberCopy.row(gBase.family + u / gOptions.familySize + 1, userId(u), created);
+        }
+        memberCopy.finish();
+    }
+
+    {
+        CopyStream copy(conn, "account",
+                        "id, id_user, account_type, account_name, balance, created_at, is_family");
+        for (int64_t u = 0; u < users; ++u) {
+            for (int a = 0; a < accounts; ++a) {
+                const char *type = kAccountTypes[static_cast<size_t>(a) % kAccountTypes.size()];
+                copy.row(accountId(u, a), userId(u), type,
+                         std::string(familyAccount(u, a) ? "Семейный " : "Счёт ") + type,
+                         money(balances[static_cast<size_t>(u * accounts + a)]), created,
+                         familyAccount(u, a));
+            }
+        }
+        copy.finish();
+    }
+
+    {
+        CopyStream copy(conn, "category", "id, id_user, name, type, is_family");
+        for (int64_t u = 0; u < users; ++u) {
+            for (int c = 0; c < kCategoriesPerUser; ++c) {
+                copy.row(categoryId(u, c), userId(u), categoryName(c),
+                         incomeCategory(c) ? "income" : "expense", familyCategory(u, c));
+            }
+        }
+        copy.finish();
+    }
+
+    {
+        // Бюджеты на личные категории расходов за последние три месяца
+        CopyStream copy(conn, "budgets",
+                        "id_user, id_category, month, year, limit_amount, created_at, is_family");
+        std::time_t now = static_cast<std::time_t>(gNow);
+        std::tm tm{};
+        gmtime_r(&now, &tm);
+        for (int64_t u = 0; u < users; ++u) {
+            for (int back = 0; back < 3; ++back) {
+                int month = tm.tm_mon + 1 - back;
+                int year = tm.tm_year + 1900;
+                if (month <= 0) {
+                    month += 12;
+                    --year;
+                }
+                for (int c = 1; c <= kFamilyExpenseCategory; ++c) {
+                    if (familyCategory(u, c)) {
+                        continue;
+                    }
+                    const auto limit = static_cast<int64_t>(
+                        kExpenseMedian[static_cast<size_t>(c - 1)] * 20 * 100);
+                    copy.row(userId(u), categoryId(u, c), month, year, money(limit), created, false);
+                }
+            }
+        }
+        copy.finish();
+    }
+
+    // Проходы 2 и 3: те же операции построчно в transactions и transfer
+    int64_t transactions = 0;
+    {
+        CopyStream copy(conn, "transactions",
+                        "id_user, id_account, id_category, amount, type, description, created_at, "
+                        "is_family");
+        for (int64_t u = 0; u < users; ++u) {
+            for (const auto &e : ledger(u)) {
+                if (e.transfer) {
+                    continue;
+                }
+                copy.row(userId(u), accountId(u, e.account), categoryId(u, e.category),
+                         money(e.cents), e.income ? "income" : "expense", categoryName(e.category),
+                         timestamp(e.at), familyAccount(u, e.account));
+            }
+            progress("transactions", u + 1, users);
+        }
+        transactions = copy.finish();
+    }
+
+    int64_t transfers = 0;
+    {
+        CopyStream copy(conn, "transfer",
+                        "id_user, account_from, account_to, amount, created_at, is_family");
+        for (int64_t u = 0; u < users; ++u) {
+            for (const auto &e : ledger(u)) {
+                if (!e.transfer) {
+                    continue;
+                }
+                copy.row(userId(u), accountId(u, e.account), accountId(u, e.accountTo),
+                         money(e.cents), timestamp(e.at),
+                         familyAccount(u, e.account) && familyAccount(u, e.accountTo));
+            }
+            progress("transfers", u + 1, users);
+        }
+        transfers = copy.finish();
+    }
+
+    // Последовательности продолжаются после явно заданных id
+    for (const char *table : {"users", "families", "account", "category"}) {
+        exec(conn, std::string("SELECT setval(pg_get_serial_sequence('") + table +
+                       "', 'id'), (SELECT COALESCE(MAX(id), 1) FROM " + table + "))");
+    }
+    exec(conn, "COMMIT");
+    exec(conn, "ANALYZE users, families, family_members, account, category, budgets, "
+               "transactions, transfer");
+
+    std::printf("{\"users\":%lld,\"families\":%lld,\"accounts\":%lld,\"categories\":%lld,"
+                "\"transactions\":%lld,\"transfers\":%lld,\"first_user_id\":%lld}\n",
+                static_cast<long long>(users), static_cast<long long>(families),
+                static_cast<long long>(users * accounts),
+                static_cast<long long>(users * kCategoriesPerUser),
+                static_cast<long long>(transactions), static_cast<long long>(transfers),
+                static_cast<long long>(gBase.user + 1));
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [--config PATH] [--client NAME] [--users N] [--family-size N]\n"
+                 "          [--accounts-per-user N] [--transactions-per-user N]\n"
+                 "          [--transfers-per-user N] [--months N] [--seed N] [--password P]\n",
+                 argv0);
+    std::exit(2);
+}
+
+void parseArgs(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        auto next = [&]() -> const char * {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+            }
+            return argv[++i];
+        };
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--config") == 0) {
+            gOptions.configPath = next();
+        } else if (std::strcmp(arg, "--client") == 0) {
+            gOptions.client = next();
+        } else if (std::strcmp(arg, "--users") == 0) {
+            gOptions.users = std::max<int64_t>(1, std::atoll(next()));
+        } else if (std::strcmp(arg, "--family-size") == 0) {
+            gOptions.familySize = std::max(0, std::atoi(next()));
+        } else if (std::strcmp(arg, "--accounts-per-user") == 0) {
+            gOptions.accountsPerUser = std::max(1, std::atoi(next()));
+        } else if (std::strcmp(arg, "--transactions-per-user") == 0) {
+            gOptions.transactionsPerUser = std::max<int64_t>(0, std::atoll(next()));
+        } else if (std::strcmp(arg, "--transfers-per-user") == 0) {
+            gOptions.transfersPerUser = std::max<int64_t>(0, std::atoll(next()));
+        } else if (std::strcmp(arg, "--months") == 0) {
+            gOptions.months = std::max(1, std::atoi(next()));
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            gOptions.seed = std::strtoull(next(), nullptr, 10);
+        } else if (std::strcmp(arg, "--password") == 0) {
+            gOptions.password = next();
+        } else {
+            usage(argv[0]);
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    parseArgs(argc, argv);
+    gNow = std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+    gWindowStart = gNow - static_cast<int64_t>(gOptions.months) * 30 * kDaySec;
+
+    std::string connInfo;
+    try {
+        connInfo = db::connectionInfo(gOptions.configPath, gOptions.client);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    PGconn *conn = PQconnectdb(connInfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        std::fprintf(stderr, "Connection failed: %s", PQerrorMessage(conn));
+        PQfinish(conn);
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    int status = 0;
+    try {
+        seed(conn);
+        std::fprintf(stderr, "Seeded in %.1f s\n",
+                     std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "\nSeeding failed: %s\n", e.what());
+        status = 1;
+    }
+    PQfinish(conn);
+    return status;
+}
@@ -8,6 +8,10 @@
 #include <cstdlib>
 #include "models/Account.h"
 #include "utils/JwtUtils.h"
+#include "db/DataBase.h"
+#include "db/AccountCache.h"
+#include "db/ReadRouting.h"
+#include "db/SingleFlight.h"
 
 
 using namespace finance;
@@ -82,10 +86,7 @@ Task<HttpResponsePtr> AccountController::createAccount(
         if (isFamily) {
             // Проверяем, что пользователь состоит в семье
             auto db = drogon::app().getFastDbClient();
-            auto familyCheck = co_await db->execSqlCoro(
-                "SELECT id_family FROM family_members WHERE id_user = $1",
-                *userIdOpt
-            );
+            auto familyCheck = co_await db::execCoro(req, db, "family_id_by_user", *userIdOpt);
             if (familyCheck.empty()) {
                 auto resp = drogon::HttpResponse::newHttpResponse();
                 resp->setStatusCode(drogon::k400BadRequest);
@@ -109,7 +110,7 @@ Task<HttpResponsePtr> AccountController::createAccount(
 
         // 6. Вставляем через ORM
         auto db = drogon::app().getFastDbClient();
-        auto mapper = drogon::orm::CoroMapper<Account>(db);
+        auto mapper = db::Mapper<Account>(db, req);
         auto inserted = co_await mapper.insert(account);
 
         // 6. Формируем ответ
@@ -150,17 +151,15 @@ Task<HttpResponsePtr> AccountController::GetAccounts(HttpRequestPtr req) {
             co_return resp;
         }
 
-        auto db = drogon::app().getFastDbClient();
-        auto mapper = drogon::orm::CoroMapper<Account>(db);
+        auto db = db::readClient(userIdOpt);
+        auto mapper = db::Mapper<Account>(db, req);
         bool familyView = req->getParameter("family") == "true";
 
         std::vector<Account> accounts;
 
         if (familyView) {
             // Проверяем членство и получаем семейные счета всех членов семьи
-            auto familyCheck = co_await db->execSqlCoro(
-                "SELECT id_family FROM family_members WHERE id_user = $1", *userIdOpt
-            );
+            auto familyCheck = co_await db::execCoro(req, db, "family_id_by_user", *userIdOpt);
             if (familyCheck.empty()) {
                 auto resp = drogon::HttpResponse::newHttpResponse();
                 resp->setStatusCode(drogon::k400BadRequest);
@@ -168,32 +167,18 @@ Task<HttpResponsePtr> AccountController::GetAccounts(HttpRequestPtr req) {
                 co_return resp;
             }
             int64_t familyId = familyCheck[0]["id_family"].as<int64_t>();
-            auto familyAccounts = co_await db->execSqlCoro(
-                R"(
-                SELECT a.id, a.id_user, a.account_type, a.account_name, a.balance, a.created_at, a.is_family
-                FROM account a
-                JOIN family_members fm ON fm.id_user = a.id_user
-                WHERE fm.id_family = $1 AND a.is_family = TRUE
-                ORDER BY a.created_at DESC
-                )",
-                familyId
-            );
+            // Одновременные запросы членов одной семьи разделяют один запрос к БД
+            auto familyAccounts = co_await db::singleFlight(
+                db::flightKey(req, "family:" + std::to_string(familyId)),
+                [req, db, familyId]() {
+                    return db::execCoro(req, db, "family_accounts", familyId);
+                });
             for (const auto &row : familyAccounts) {
                 accounts.emplace_back(Account(row));
             }
         } else {
             // Личные счета текущего пользователя (без семейных), сортировка по дате
-            auto personalAccounts = co_await db->execSqlCoro(
-                R"(
-                /*personal_accounts_v3_ordered*/
-                SELECT id, id_user, account_type, account_name, balance, created_at, is_family
-                FROM account
-                WHERE id_user = $1::int8
-                  AND is_family = FALSE
-                ORDER BY created_at DESC
-                )",
-                static_cast<int64_t>(*userIdOpt)
-            );
+            auto personalAccounts = co_await db::execCoro(req, db, "personal_accounts_v3_ordered", static_cast<int64_t>(*userIdOpt));
             for (const auto &row : personalAccounts) {
                 accounts.emplace_back(Account(row));
             }
@@ -225,10 +210,10 @@ Task<HttpResponsePtr> AccountController::GetAccounts(HttpRequestPtr req) {
 }
 
 Task<HttpResponsePtr> AccountController::GetAccountById(
-    HttpRequestPtr /*req*/, int accountId) {
+    HttpRequestPtr req, int accountId) {
     try {
         auto db = drogon::app().getFastDbClient();
-        auto mapper = drogon::orm::CoroMapper<Account>(db);
+        auto mapper = db::Mapper<Account>(db, req);
         auto account = co_await mapper.findByPrimaryKey(accountId);
 
         auto resp = drogon::HttpResponse::newHttpJsonResponse(account.toJson());
@@ -270,7 +255,7 @@ Task<HttpResponsePtr> AccountController::UpdateAccount(
         bool isFamilyRequest = req->getParameter("family") == "true";
 
         auto db = drogon::app().getFastDbClient();
-        auto mapper = drogon::orm::CoroMapper<Account>(db);
+        auto mapper = db::Mapper<Account>(db, req);
         auto account = co_await mapper.findByPrimaryKey(accountId);
 
         bool accIsFamily = account.getIsFamily() && *account.getIsFamily();
@@ -283,13 +268,7 @@ Task<HttpResponsePtr> AccountController::UpdateAccount(
 
         if (accIsFamily) {
             // Проверяем, что пользователь и владелец счета в одной семье
-            auto familyCheck = co_await db->execSqlCoro(
-                R"(
-                /*account_update_family_scope*/
-                SELECT 1 FROM family_members fm1
-                JOIN family_members fm2 ON fm1.id_family = fm2.id_family
-                WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
-                )",
+            auto familyCheck = co_await db::execCoro(req, db, "account_update_family_scope",
                 static_cast<int64_t>(*userIdOpt),
                 static_cast<int64_t>(account.getValueOfIdUser())
             );
@@ -341,6 +320,7 @@ Task<HttpResponsePtr> AccountController::UpdateAccount(
         }
 
         co_await mapper.update(account);
+        db::accounts::invalidate(accountId);
 
         auto resp = drogon::HttpResponse::newHttpJsonResponse(account.toJson());
         resp->setStatusCode(drogon::k200OK);
@@ -360,11 +340,12 @@ Task<HttpResponsePtr> AccountController::UpdateAccount(
 }
 
 Task<HttpResponsePtr> AccountController::DeleteAccount(
-    HttpRequestPtr /*req*/, int accountId) {
+    HttpRequestPtr req, int accountId) {
     try {
         auto db = drogon::app().getFastDbClient();
-        auto mapper = drogon::orm::CoroMapper<Account>(db);
+        auto mapper = db::Mapper<Account>(db, req);
         co_await mapper.deleteByPrimaryKey(accountId);
+        db::accounts::invalidate(accountId);
 
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k204NoContent);
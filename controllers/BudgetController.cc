@@ -4,6 +4,9 @@
 #include <jsoncpp/json/json.h>
 #include <drogon/HttpAppFramework.h>
 #include "utils/JwtUtils.h"
+#include "db/DataBase.h"
+#include "db/CategoryCache.h"
+#include "db/ReadRouting.h"
 
 using namespace finance;
 using namespace drogon_model::financial_manager;
@@ -44,10 +47,7 @@ Task<HttpResponsePtr> BudgetController::CreateBudget(HttpRequestPtr req) {
         if (isFamily) {
             // Проверяем, что пользователь состоит в семье
             auto db = drogon::app().getFastDbClient();
-            auto familyCheck = co_await db->execSqlCoro(
-                "SELECT id_family FROM family_members WHERE id_user = $1",
-                *userIdOpt
-            );
+            auto familyCheck = co_await db::execCoro(req, db, "family_id_by_user", *userIdOpt);
             if (familyCheck.empty()) {
                 auto resp = drogon::HttpResponse::newHttpResponse();
                 resp->setStatusCode(drogon::k400BadRequest);
@@ -71,9 +71,7 @@ Task<HttpResponsePtr> BudgetController::CreateBudget(HttpRequestPtr req) {
         auto db = drogon::app().getFastDbClient();
         // Проверка на дубликат бюджета для той же категории/месяца/года в рамках режима (личный/семейный)
         if (isFamily) {
-            auto familyCheck = co_await db->execSqlCoro(
-                "SELECT id_family FROM family_members WHERE id_user = $1", *userIdOpt
-            );
+            auto familyCheck = co_await db::execCoro(req, db, "family_id_by_user", *userIdOpt);
             if (familyCheck.empty()) {
                 auto resp = drogon::HttpResponse::newHttpResponse();
                 resp->setStatusCode(drogon::k400BadRequest);
@@ -81,18 +79,7 @@ Task<HttpResponsePtr> BudgetController::CreateBudget(HttpRequestPtr req) {
                 co_return resp;
             }
             int64_t familyId = familyCheck[0]["id_family"].as<int64_t>();
-            auto dup = co_await db->execSqlCoro(
-                R"(
-                /*budget_dup_family_v2*/
-                SELECT 1 FROM budgets b
-                JOIN family_members fm ON fm.id_user = b.id_user
-                WHERE fm.id_family = $1::int8
-                  AND b.id_category = $2::int4
-                  AND b.month = $3::int4
-                  AND b.year = $4::int4
-                  AND b.is_family = TRUE
-                LIMIT 1
-                )",
+            auto dup = co_await db::execCoro(req, db, "budget_dup_family_v2",
                 familyId,
                 static_cast<int32_t>(b.getValueOfIdCategory()),
                 static_cast<int32_t>(b.getValueOfMonth()),
@@ -105,17 +92,7 @@ Task<HttpResponsePtr> BudgetController::CreateBudget(HttpRequestPtr req) {
                 co_return resp;
             }
         } else {
-            auto dup = co_await db->execSqlCoro(
-                R"(
-                /*budget_dup_personal_v2*/
-                SELECT 1 FROM budgets
-                WHERE id_user = $1::int8
-                  AND id_category = $2::int4
-                  AND month = $3::int4
-                  AND year = $4::int4
-                  AND is_family = FALSE
-                LIMIT 1
-                )",
+            auto dup = co_await db::execCoro(req, db, "budget_dup_personal_v2",
                 static_cast<int64_t>(*userIdOpt),
                 static_cast<int32_t>(b.getValueOfIdCategory()),
                 static_cast<int32_t>(b.getValueOfMonth()),
@@ -129,7 +106,7 @@ Task<HttpResponsePtr> BudgetController::CreateBudget(HttpRequestPtr req) {
             }
         }
 
-        drogon::orm::CoroMapper<Budgets> mapper(db);
+        db::Mapper<Budgets> mapper(db, req);
         auto inserted = co_await mapper.insert(b);
 
         auto resp = drogon::HttpResponse::newHttpJsonResponse(inserted.toJson());
@@ -146,8 +123,6 @@ Task<HttpResponsePtr> BudgetController::CreateBudget(HttpRequestPtr req) {
 
 Task<HttpResponsePtr> BudgetController::GetBudgets(HttpRequestPtr req) {
     try {
-        auto db = drogon::app().getFastDbClient();
-
         auto userIdOpt = jwt_utils::getUserIdFromRequest(req);
         if (!userIdOpt) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -156,25 +131,15 @@ Task<HttpResponsePtr> BudgetController::GetBudgets(HttpRequestPtr req) {
             co_return resp;
         }
 
+        auto db = db::readClient(userIdOpt);
+
         // Проверяем параметр family
         bool isFamily = req->getParameter("family") == "true";
         
         Json::Value arr(Json::arrayValue);
         
         if (isFamily) {
-            auto familyBudgets = co_await db->execSqlCoro(
-                R"(
-                /*family_budgets_v3_ordered*/
-                SELECT b.id, b.id_user, b.id_category, b.month, b.year, b.limit_amount, b.is_family, b.created_at
-                FROM budgets b
-                JOIN family_members fm ON fm.id_user = b.id_user
-                WHERE fm.id_family IN (
-                    SELECT fm2.id_family FROM family_members fm2 WHERE fm2.id_user = $1
-                )
-                AND b.is_family = TRUE
-                ORDER BY b.year DESC, b.month DESC
-                )", *userIdOpt
-            );
+            auto familyBudgets = co_await db::execCoro(req, db, "family_budgets_v3_ordered", *userIdOpt);
             for (const auto &row : familyBudgets) {
                 auto budgetJson = Budgets(row).toJson();
                 budgetJson["is_family"] = true;
@@ -182,17 +147,7 @@ Task<HttpResponsePtr> BudgetController::GetBudgets(HttpRequestPtr req) {
             }
         } else {
             // Получаем только личные бюджеты, сортируем по дате
-            auto personalBudgets = co_await db->execSqlCoro(
-                R"(
-                /*personal_budgets_v2_ordered*/
-                SELECT id, id_user, id_category, month, year, limit_amount, is_family, created_at
-                FROM budgets
-                WHERE id_user = $1::int8
-                  AND is_family = FALSE
-                ORDER BY year DESC, month DESC
-                )",
-                static_cast<int64_t>(*userIdOpt)
-            );
+            auto personalBudgets = co_await db::execCoro(req, db, "personal_budgets_v2_ordered", static_cast<int64_t>(*userIdOpt));
             for (const auto &row : personalBudgets) {
                 auto b = Budgets(row);
                 auto budgetJson = b.toJson();
@@ -234,7 +189,7 @@ Task<HttpResponsePtr> BudgetController::UpdateBudget(HttpRequestPtr req, int bud
         }
 
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Budgets> mapper(db);
+        db::Mapper<Budgets> mapper(db, req);
         auto b = co_await mapper.findByPrimaryKey(budgetId);
 
         bool budgetIsFamily = b.getIsFamily() && *b.getIsFamily();
@@ -246,13 +201,7 @@ Task<HttpResponsePtr> BudgetController::UpdateBudget(HttpRequestPtr req, int bud
         }
 
         if (budgetIsFamily) {
-            auto familyCheck = co_await db->execSqlCoro(
-                R"(
-                /*budget_update_family_scope*/
-                SELECT 1 FROM family_members fm1
-                JOIN family_members fm2 ON fm1.id_family = fm2.id_family
-                WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
-                )",
+            auto familyCheck = co_await db::execCoro(req, db, "budget_update_family_scope",
                 static_cast<int64_t>(*userIdOpt),
                 static_cast<int64_t>(b.getValueOfIdUser())
             );
@@ -290,16 +239,14 @@ Task<HttpResponsePtr> BudgetController::UpdateBudget(HttpRequestPtr req, int bud
         }
 
         // Проверяем категорию
-        auto catRows = co_await db->execSqlCoro(
-            "SELECT id_user, is_family FROM category WHERE id = $1", newCategoryId
-        );
-        if (catRows.empty()) {
+        auto category = co_await db::categories::find(req, newCategoryId);
+        if (!category) {
             auto resp = drogon::HttpResponse::newHttpResponse();
             resp->setStatusCode(drogon::k400BadRequest);
             resp->setBody("Category not found");
             co_return resp;
         }
-        bool catIsFamily = !catRows[0]["is_family"].isNull() && catRows[0]["is_family"].as<bool>();
+        bool catIsFamily = category->isFamily;
         if (catIsFamily != budgetIsFamily) {
             auto resp = drogon::HttpResponse::newHttpResponse();
             resp->setStatusCode(drogon::k403Forbidden);
@@ -307,15 +254,9 @@ Task<HttpResponsePtr> BudgetController::UpdateBudget(HttpRequestPtr req, int bud
             co_return resp;
         }
         if (budgetIsFamily) {
-            auto familyCheck = co_await db->execSqlCoro(
-                R"(
-                /*budget_update_cat_family*/
-                SELECT 1 FROM family_members fm1
-                JOIN family_members fm2 ON fm1.id_family = fm2.id_family
-                WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
-                )",
+            auto familyCheck = co_await db::execCoro(req, db, "budget_update_cat_family",
                 static_cast<int64_t>(*userIdOpt),
-                static_cast<int64_t>(catRows[0]["id_user"].as<int64_t>())
+                category->idUser
             );
             if (familyCheck.empty()) {
                 auto resp = drogon::HttpResponse::newHttpResponse();
@@ -324,7 +265,7 @@ Task<HttpResponsePtr> BudgetController::UpdateBudget(HttpRequestPtr req, int bud
                 co_return resp;
             }
         } else {
-            if (catRows[0]["id_user"].as<int>() != static_cast<int32_t>(*userIdOpt)) {
+            if (category->idUser != *userIdOpt) {
                 auto resp = drogon::HttpResponse::newHttpResponse();
                 resp->setStatusCode(drogon::k403Forbidden);
                 resp->setBody("Category does not belong to user");
@@ -334,19 +275,7 @@ Task<HttpResponsePtr> BudgetController::UpdateBudget(HttpRequestPtr req, int bud
 
         // Проверяем дубликаты
         if (budgetIsFamily) {
-            auto dupCheck = co_await db->execSqlCoro(
-                R"(
-                /*budget_dup_update_family_v1*/
-                SELECT 1 FROM budgets b
-                JOIN family_members fm1 ON fm1.id_user = b.id_user
-                JOIN family_members fm2 ON fm1.id_family = fm2.id_family
-                WHERE fm2.id_user = $1::int8
-                  AND b.id_category = $2::int4
-                  AND b.month = $3::int4
-                  AND b.year = $4::int4
-                  AND b.is_family = TRUE
-                  AND b.id <> $5::int4
-                )",
+            auto dupCheck = co_await db::execCoro(req, db, "budget_dup_update_family_v1",
                 static_cast<int64_t>(*userIdOpt),
                 newCategoryId,
                 newMonth,
@@ -360,17 +289,7 @@ Task<HttpResponsePtr> BudgetController::UpdateBudget(HttpRequestPtr req, int bud
                 co_return resp;
             }
         } else {
-            auto dupCheck = co_await db->execSqlCoro(
-                R"(
-                /*budget_dup_update_personal_v1*/
-                SELECT 1 FROM budgets
-                WHERE id_user = $1::int8
-                  AND id_category = $2::int4
-                  AND month = $3::int4
-                  AND year = $4::int4
-                  AND is_family = FALSE
-                  AND id <> $5::int4
-                )",
+            auto dupCheck = co_await db::execCoro(req, db, "budget_dup_update_personal_v1",
                 static_cast<int64_t>(*userIdOpt),
                 newCategoryId,
                 newMonth,
@@ -429,7 +348,7 @@ Task<HttpResponsePtr> BudgetController::DeleteBudget(HttpRequestPtr req, int bud
         bool isFamilyRequest = req->getParameter("family") == "true";
 
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Budgets> mapper(db);
+        db::Mapper<Budgets> mapper(db, req);
         auto b = co_await mapper.findByPrimaryKey(budgetId);
 
         bool budgetIsFamily = b.getIsFamily() && *b.getIsFamily();
@@ -441,13 +360,7 @@ Task<HttpResponsePtr> BudgetController::DeleteBudget(HttpRequestPtr req, int bud
         }
 
         if (budgetIsFamily) {
-            auto familyCheck = co_await db->execSqlCoro(
-                R"(
-                /*budget_delete_family_scope*/
-                SELECT 1 FROM family_members fm1
-                JOIN family_members fm2 ON fm1.id_family = fm2.id_family
-                WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
-                )",
+            auto familyCheck = co_await db::execCoro(req, db, "budget_delete_family_scope",
                 static_cast<int64_t>(*userIdOpt),
                 static_cast<int64_t>(b.getValueOfIdUser())
             );
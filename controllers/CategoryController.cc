@@ -4,6 +4,9 @@
 #include <jsoncpp/json/json.h>
 #include <drogon/HttpAppFramework.h>
 #include "utils/JwtUtils.h"
+#include "db/DataBase.h"
+#include "db/ReadRouting.h"
+#include "db/CategoryCache.h"
 
 using namespace finance;
 using namespace drogon_model::financial_manager;
@@ -52,10 +55,7 @@ Task<HttpResponsePtr> CategoryController::CreateCategory(HttpRequestPtr req) {
         if (isFamily) {
             // Проверяем, что пользователь состоит в семье
             auto db = drogon::app().getFastDbClient();
-            auto familyCheck = co_await db->execSqlCoro(
-                "SELECT id_family FROM family_members WHERE id_user = $1",
-                *userIdOpt
-            );
+            auto familyCheck = co_await db::execCoro(req, db, "family_id_by_user", *userIdOpt);
             if (familyCheck.empty()) {
                 auto resp = drogon::HttpResponse::newHttpResponse();
                 resp->setStatusCode(drogon::k400BadRequest);
@@ -65,7 +65,7 @@ Task<HttpResponsePtr> CategoryController::CreateCategory(HttpRequestPtr req) {
         }
 
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Category> mapper(db);
+        db::Mapper<Category> mapper(db, req);
 
         Category cat;
         cat.setIdUser(static_cast<int32_t>(*userIdOpt));
@@ -76,6 +76,7 @@ Task<HttpResponsePtr> CategoryController::CreateCategory(HttpRequestPtr req) {
         }
 
         auto inserted = co_await mapper.insert(cat);
+        db::categories::invalidate(inserted.getValueOfId(), *userIdOpt);
 
         auto result = inserted.toJson();
         // Убеждаемся, что is_family правильно установлен в ответе
@@ -100,8 +101,6 @@ Task<HttpResponsePtr> CategoryController::CreateCategory(HttpRequestPtr req) {
 
 Task<HttpResponsePtr> CategoryController::GetCategories(HttpRequestPtr req) {
     try {
-        auto db = drogon::app().getFastDbClient();
-
         auto userIdOpt = jwt_utils::getUserIdFromRequest(req);
         if (!userIdOpt) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -110,6 +109,8 @@ Task<HttpResponsePtr> CategoryController::GetCategories(HttpRequestPtr req) {
             co_return resp;
         }
 
+        auto db = db::readClient(userIdOpt);
+
         // Проверяем параметр family
         bool isFamily = req->getParameter("family") == "true";
         
@@ -117,62 +118,21 @@ Task<HttpResponsePtr> CategoryController::GetCategories(HttpRequestPtr req) {
         
         if (isFamily) {
             // Получаем семейные категории (категории всех членов семьи)
-            auto familyMembers = co_await db->execSqlCoro(
-                R"(
-                SELECT DISTINCT fm.id_user
-                FROM family_members fm
-                WHERE fm.id_family = (
-                    SELECT fm2.id_family 
-                    FROM family_members fm2 
-                    WHERE fm2.id_user = $1
-                )
-                )", *userIdOpt
-            );
+            auto familyCheck = co_await db::execCoro(req, db, "family_id_by_user", *userIdOpt);
             
-            if (!familyMembers.empty()) {
-                // Получаем семейные категории всех членов семьи (только is_family = true)
-                auto familyCategories = co_await db->execSqlCoro(
-                    R"(
-                    SELECT c.id, c.id_user, c.name, c.type, c.is_family
-                    FROM category c
-                    JOIN family_members fm ON fm.id_user = c.id_user
-                    WHERE fm.id_family IN (
-                        SELECT fm2.id_family FROM family_members fm2 WHERE fm2.id_user = $1
-                    )
-                    AND c.is_family = TRUE
-                    )", *userIdOpt
-                );
-
-                for (const auto &row : familyCategories) {
-                    Json::Value catJson;
-                    catJson["id"] = (Json::Int64)row["id"].as<int64_t>();
-                    catJson["id_user"] = (Json::Int64)row["id_user"].as<int64_t>();
-                    catJson["name"] = row["name"].as<std::string>();
-                    catJson["type"] = row["type"].as<std::string>();
-                    catJson["is_family"] = true;
-                    arr.append(catJson);
+            if (!familyCheck.empty()) {
+                // Семейные категории всех членов семьи (только is_family = true) из кэша
+                int64_t familyId = familyCheck[0]["id_family"].as<int64_t>();
+                auto familyCategories = co_await db::categories::family(req, familyId);
+                for (const auto &c : *familyCategories) {
+                    arr.append(db::categories::toJson(c));
                 }
             }
         } else {
-            // Получаем только личные категории пользователя
-            drogon::orm::CoroMapper<Category> mapper(db);
-            std::vector<Category> cats = co_await mapper.findBy(
-                drogon::orm::Criteria(Category::Cols::_id_user,
-                                      drogon::orm::CompareOperator::EQ,
-                                      static_cast<int32_t>(*userIdOpt))
-                && drogon::orm::Criteria(Category::Cols::_is_family,
-                                         drogon::orm::CompareOperator::EQ,
-                                         false));
-            for (const auto &c : cats) {
-                auto catJson = c.toJson();
-                // Проверяем, является ли категория семейной
-                auto isFamilyPtr = c.getIsFamily();
-                if (isFamilyPtr && *isFamilyPtr) {
-                    catJson["is_family"] = true;
-                } else {
-                    catJson["is_family"] = false;
-                }
-                arr.append(catJson);
+            // Получаем только личные категории пользователя из кэша
+            auto cats = co_await db::categories::personal(req, *userIdOpt);
+            for (const auto &c : *cats) {
+                arr.append(db::categories::toJson(c));
             }
         }
 
@@ -209,7 +169,7 @@ Task<HttpResponsePtr> CategoryController::UpdateCategory(HttpRequestPtr req, int
         }
 
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Category> mapper(db);
+        db::Mapper<Category> mapper(db, req);
 
         auto cat = co_await mapper.findByPrimaryKey(categoryId);
 
@@ -223,13 +183,7 @@ Task<HttpResponsePtr> CategoryController::UpdateCategory(HttpRequestPtr req, int
 
         if (catIsFamily) {
             auto db = drogon::app().getFastDbClient();
-            auto familyCheck = co_await db->execSqlCoro(
-                R"(
-                /*category_update_family_scope*/
-                SELECT 1 FROM family_members fm1
-                JOIN family_members fm2 ON fm1.id_family = fm2.id_family
-                WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
-                )",
+            auto familyCheck = co_await db::execCoro(req, db, "category_update_family_scope",
                 static_cast<int64_t>(*userIdOpt),
                 static_cast<int64_t>(cat.getValueOfIdUser())
             );
@@ -263,6 +217,7 @@ Task<HttpResponsePtr> CategoryController::UpdateCategory(HttpRequestPtr req, int
         }
 
         co_await mapper.update(cat);
+        db::categories::invalidate(categoryId, cat.getValueOfIdUser());
 
         auto resp = drogon::HttpResponse::newHttpJsonResponse(cat.toJson());
         resp->setStatusCode(drogon::k200OK);
@@ -294,7 +249,7 @@ Task<HttpResponsePtr> CategoryController::DeleteCategory(HttpRequestPtr req, int
         bool isFamilyRequest = req->getParameter("family") == "true";
 
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Category> mapper(db);
+        db::Mapper<Category> mapper(db, req);
         auto cat = co_await mapper.findByPrimaryKey(categoryId);
 
         bool catIsFamily = cat.getIsFamily() && *cat.getIsFamily();
@@ -306,13 +261,7 @@ Task<HttpResponsePtr> CategoryController::DeleteCategory(HttpRequestPtr req, int
         }
 
         if (catIsFamily) {
-            auto familyCheck = co_await db->execSqlCoro(
-                R"(
-                /*category_delete_family_scope*/
-                SELECT 1 FROM family_members fm1
-                JOIN family_members fm2 ON fm1.id_family = fm2.id_family
-                WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
-                )",
+            auto familyCheck = co_await db::execCoro(req, db, "category_delete_family_scope",
                 static_cast<int64_t>(*userIdOpt),
                 static_cast<int64_t>(cat.getValueOfIdUser())
             );
@@ -332,6 +281,7 @@ Task<HttpResponsePtr> CategoryController::DeleteCategory(HttpRequestPtr req, int
         }
 
         co_await mapper.deleteByPrimaryKey(categoryId);
+        db::categories::invalidate(categoryId, cat.getValueOfIdUser());
 
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k204NoContent);
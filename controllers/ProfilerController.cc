@@ -0,0 +1,111 @@
+#include "ProfilerController.h"
+#include <drogon/HttpResponse.h>
+#include <drogon/drogon.h>
+#include <drogon/utils/coroutine.h>
+#include <trantor/net/EventLoop.h>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include "utils/CpuProfiler.h"
+#include "utils/JwtUtils.h"
+
+using namespace finance;
+using drogon::HttpRequestPtr;
+using drogon::HttpResponsePtr;
+using drogon::Task;
+
+namespace {
+
+HttpResponsePtr textResponse(drogon::HttpStatusCode code, const std::string &body) {
+    auto resp = drogon::HttpResponse::newHttpResponse();
+    resp->setStatusCode(code);
+    resp->setBody(body);
+    return resp;
+}
+
+bool isAdmin(const Json::Value &cfg, int64_t userId) {
+    for (const auto &id : cfg["admin_user_ids"]) {
+        if (id.asInt64() == userId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Целый параметр запроса в [minValue, maxValue]; fallback, если параметра нет.
+// Значение должно быть числом целиком ("10s" и "10 " — ошибка),
+// иначе std::invalid_argument. minValue <= maxValue (см. finance::setupApp).
+int intParam(const HttpRequestPtr &req, const std::string &name, int fallback,
+             int minValue, int maxValue) {
+    const auto &value = req->getParameter(name);
+    int parsed = fallback;
+    if (!value.empty()) {
+        const char *end = value.data() + value.size();
+        const auto [ptr, ec] = std::from_chars(value.data(), end, parsed);
+        if (ec != std::errc() || ptr != end) {
+            throw std::invalid_argument(name + " is not an integer");
+        }
+    }
+    return std::clamp(parsed, minValue, maxValue);
+}
+
+}
+
+Task<HttpResponsePtr> ProfilerController::CpuProfile(HttpRequestPtr req) {
+    const auto &cfg = drogon::app().getCustomConfig()["profiler"];
+    // Выключенный профилировщик не выдаёт себя даже администраторам
+    if (!cfg.get("enabled", false).asBool()) {
+        co_return textResponse(drogon::k404NotFound, "Not found");
+    }
+    auto userIdOpt = jwt_utils::getUserIdFromRequest(req);
+    if (!userIdOpt) {
+        co_return textResponse(drogon::k401Unauthorized, "Unauthorized");
+    }
+    if (!isAdmin(cfg, *userIdOpt)) {
+        co_return textResponse(drogon::k403Forbidden, "Forbidden");
+    }
+
+    int seconds = 0;
+    int hz = 0;
+    try {
+        seconds = intParam(req, "seconds", cfg.get("default_seconds", 10).asInt(), 1,
+                           cfg.get("max_seconds", 30).asInt());
+        hz = intParam(req, "hz", cfg.get("default_hz", 99).asInt(), 1, 1000);
+    } catch (const std::exception &) {
+        co_return textResponse(drogon::k400BadRequest, "seconds and hz must be integers");
+    }
+
+    std::string error;
+    switch (cpu_profiler::start(hz, error)) {
+    case cpu_profiler::StartResult::Busy:
+        co_return textResponse(drogon::k409Conflict, error);
+    case cpu_profiler::StartResult::Failed:
+        LOG_ERROR << "CPU profile failed to start: " << error;
+        co_return textResponse(drogon::k500InternalServerError, error);
+    case cpu_profiler::StartResult::Started:
+        break;
+    }
+    LOG_INFO << "CPU profile started by user " << *userIdOpt << ": " << seconds << "s at "
+             << hz << "Hz";
+
+    cpu_profiler::Profile profile;
+    try {
+        auto *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        co_await drogon::sleepCoro(loop ? loop : drogon::app().getLoop(),
+                                   static_cast<double>(seconds));
+        profile = cpu_profiler::stop();
+    } catch (...) {
+        cpu_profiler::stop();
+        throw;
+    }
+    LOG_INFO << "CPU profile finished: samples=" << profile.samples
+             << " dropped=" << profile.dropped << " threads=" << profile.threads;
+
+    auto resp = textResponse(drogon::k200OK, profile.folded);
+    resp->setContentTypeCode(drogon::CT_TEXT_PLAIN);
+    resp->addHeader("Content-Disposition", "attachment; filename=\"cpu.folded\"");
+    resp->addHeader("X-Profile-Samples", std::to_string(profile.samples));
+    resp->addHeader("X-Profile-Dropped", std::to_string(profile.dropped));
+    co_return resp;
+}
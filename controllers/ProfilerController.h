@@ -0,0 +1,20 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace finance {
+
+// Профилирование работающего процесса для администраторов из
+// custom_config.profiler.admin_user_ids (utils/CpuProfiler.h)
+class ProfilerController : public drogon::HttpController<ProfilerController> {
+public:
+    METHOD_LIST_BEGIN
+        ADD_METHOD_TO(ProfilerController::CpuProfile, "/api/admin/profile/cpu", drogon::Get);
+    METHOD_LIST_END
+
+    // ?seconds=N&hz=M — профиль CPU всех потоков за N секунд в виде свёрнутых
+    // стеков (text/plain) для flamegraph.pl или speedscope
+    drogon::Task<drogon::HttpResponsePtr> CpuProfile(drogon::HttpRequestPtr req);
+};
+
+}
@@ -1,11 +1,22 @@
 #include "UserController.h"
+#include <cmath>
 #include <drogon/HttpResponse.h>
 #include <drogon/orm/CoroMapper.h>
 #include <jsoncpp/json/json.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/HttpViewData.h>
+#include <trantor/net/EventLoopThread.h>
+#include <mutex>
+#include "utils/ClientIp.h"
 #include "utils/PasswordUtils.h"
 #include "utils/JwtUtils.h"
+#include "utils/LoginThrottle.h"
+#include "utils/Log.h"
+#include "db/DataBase.h"
+#include "db/AccountCache.h"
+#include "db/CategoryCache.h"
+#include "db/ReadRouting.h"
+#include "db/SingleFlight.h"
 #include "models/FamilyMembers.h"
 #include "models/FamilyInvite.h"
 
@@ -16,6 +27,57 @@ using drogon::HttpRequestPtr;
 using drogon::HttpResponsePtr;
 using drogon::Task;
 
+namespace {
+
+slog::Module &kFamilyLog = slog::module("family");
+
+// Ответ на попытку входа, пока действует пауза после неудачных попыток
+HttpResponsePtr throttledResponse(double retryAfterSec) {
+    auto resp = drogon::HttpResponse::newHttpResponse();
+    resp->setStatusCode(drogon::k429TooManyRequests);
+    resp->addHeader("Retry-After", std::to_string(static_cast<int64_t>(std::ceil(retryAfterSec))));
+    resp->setBody("Too many failed attempts, retry later");
+    return resp;
+}
+
+// Пересчитывает устаревший хеш пароля после успешного входа. Хеширование
+// идёт в отдельном потоке, чтобы не задерживать IO-поток; запись — снова
+// в IO-потоке, где доступен fast-клиент БД, через db::execCoro (метрики и
+// журнал медленных запросов, как у остальных запросов).
+void rehashInBackground(int64_t userId, std::string password, std::string oldHash) {
+    static trantor::EventLoopThread worker("PasswordRehash");
+    static std::once_flag started;
+    std::call_once(started, [] { worker.run(); });
+
+    auto *ioLoop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (!ioLoop) {
+        return;
+    }
+    worker.getLoop()->queueInLoop([ioLoop, userId, password = std::move(password),
+                                   oldHash = std::move(oldHash)]() {
+        std::string newHash;
+        try {
+            newHash = security::hashPassword(password);
+        } catch (const std::exception &e) {
+            LOG_ERROR << "Password rehash failed for user " << userId << ": " << e.what();
+            return;
+        }
+        ioLoop->queueInLoop([userId, newHash = std::move(newHash), oldHash]() {
+            drogon::async_run([userId, newHash, oldHash]() -> Task<> {
+                try {
+                    co_await db::execCoro(nullptr, drogon::app().getFastDbClient(),
+                                          "user_password_rehash", newHash, userId, oldHash);
+                } catch (const std::exception &e) {
+                    LOG_ERROR << "Password rehash update failed for user " << userId
+                              << ": " << e.what();
+                }
+            });
+        });
+    });
+}
+
+}
+
 Task<HttpResponsePtr> UserController::Register(HttpRequestPtr req) {
     try {
         auto json = req->getJsonObject();
@@ -40,7 +102,7 @@ Task<HttpResponsePtr> UserController::Register(HttpRequestPtr req) {
         std::string password = (*json)["password"].asString();
 
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Users> mapper(db);
+        db::Mapper<Users> mapper(db, req);
 
         // Проверяем, что такого email ещё нет
         try {
@@ -104,8 +166,15 @@ Task<HttpResponsePtr> UserController::Login(HttpRequestPtr req) {
         std::string email = (*json)["email"].asString();
         std::string password = (*json)["password"].asString();
 
+        // Пауза после неудачных попыток проверяется до обращения к БД и PBKDF2
+        const std::string ip = security::clientIp(req);
+        security::throttle::Attempt attempt(email, ip);
+        if (double wait = attempt.retryAfter(); wait > 0) {
+            co_return throttledResponse(wait);
+        }
+
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Users> mapper(db);
+        db::Mapper<Users> mapper(db, req);
 
         Users user;
         try {
@@ -114,6 +183,7 @@ Task<HttpResponsePtr> UserController::Login(HttpRequestPtr req) {
                                       drogon::orm::CompareOperator::EQ,
                                       email));
         } catch (const drogon::orm::UnexpectedRows & ) {
+            attempt.failed();
             auto resp = drogon::HttpResponse::newHttpResponse();
             resp->setStatusCode(drogon::k401Unauthorized);
             resp->setBody("Invalid credentials");
@@ -121,12 +191,18 @@ Task<HttpResponsePtr> UserController::Login(HttpRequestPtr req) {
         }
 
         if (!security::verifyPassword(password, user.getValueOfHashedPassword())) {
+            attempt.failed();
             auto resp = drogon::HttpResponse::newHttpResponse();
             resp->setStatusCode(drogon::k401Unauthorized);
             resp->setBody("Invalid credentials");
             co_return resp;
         }
 
+        attempt.succeeded();
+        if (security::needsRehash(user.getValueOfHashedPassword())) {
+            rehashInBackground(user.getValueOfId(), password, user.getValueOfHashedPassword());
+        }
+
         Json::Value result;
         result["id"] = user.getValueOfId();
         result["name"] = user.getValueOfName();
@@ -155,8 +231,8 @@ Task<HttpResponsePtr> UserController::GetProfile(HttpRequestPtr req) {
             co_return resp;
         }
 
-        auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Users> mapper(db);
+        auto db = db::readClient(userIdOpt);
+        db::Mapper<Users> mapper(db, req);
         auto user = co_await mapper.findByPrimaryKey(static_cast<int32_t>(*userIdOpt));
 
         Json::Value profile;
@@ -164,14 +240,7 @@ Task<HttpResponsePtr> UserController::GetProfile(HttpRequestPtr req) {
         profile["name"] = user.getValueOfName();
         profile["email"] = user.getValueOfEmail();
 
-        auto family = co_await db->execSqlCoro(
-            R"(
-            SELECT f.id, f.name, f.id_owner
-            FROM families f
-            JOIN family_members fm ON f.id = fm.id_family
-            WHERE fm.id_user = $1
-            )", user.getValueOfId()
-        );
+        auto family = co_await db::execCoro(req, db, "family_by_member", user.getValueOfId());
 
         if (!family.empty()) {
             profile["family"] = Json::Value(Json::objectValue);
@@ -215,7 +284,7 @@ Task<HttpResponsePtr> UserController::UpdateProfile(HttpRequestPtr req) {
         }
 
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Users> mapper(db);
+        db::Mapper<Users> mapper(db, req);
         auto user = co_await mapper.findByPrimaryKey(static_cast<int32_t>(*userIdOpt));
 
         if (json->isMember("name")) {
@@ -263,8 +332,10 @@ Task<HttpResponsePtr> UserController::DeleteAccount(HttpRequestPtr req) {
         }
 
         auto db = drogon::app().getFastDbClient();
-        drogon::orm::CoroMapper<Users> mapper(db);
+        db::Mapper<Users> mapper(db, req);
         co_await mapper.deleteByPrimaryKey(static_cast<int32_t>(*userIdOpt));
+        db::categories::invalidateUser(*userIdOpt);
+        db::accounts::invalidateUser(*userIdOpt);
 
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k204NoContent);
@@ -308,7 +379,7 @@ Task<HttpResponsePtr> UserController::CreateFamily(HttpRequestPtr req) {
         int64_t idUser = *IdUserOpt;
         auto db = drogon::app().getFastDbClient();
         //проверяем, есть ли пользователь уже в какой - то семье
-        auto memberCheck = co_await db->execSqlCoro("SELECT 1 FROM family_members WHERE id_user = $1", idUser);
+        auto memberCheck = co_await db::execCoro(req, db, "family_membership_exists", idUser);
         if (!memberCheck.empty()) {
             auto resp = drogon::HttpResponse::newHttpResponse();
             resp->setStatusCode(drogon::k400BadRequest);
@@ -316,14 +387,14 @@ Task<HttpResponsePtr> UserController::CreateFamily(HttpRequestPtr req) {
             co_return resp;
         }
         std::string name = (*json)["name"].asString();
-        drogon::orm::CoroMapper<Families> mapper(db);
+        db::Mapper<Families> mapper(db, req);
 
         Families family;
         family.setName(name);
         family.setIdOwner(idUser);
         auto inserted = co_await mapper.insert(family);
 
-        drogon::orm::CoroMapper<FamilyMembers> membersMapper(db);
+        db::Mapper<FamilyMembers> membersMapper(db, req);
         FamilyMembers member;
         member.setIdFamily(inserted.getValueOfId());
         member.setIdUser(idUser);
@@ -361,8 +432,7 @@ Task<HttpResponsePtr> UserController::InviteToFamily(HttpRequestPtr req, int64_t
         // family_members хранит id_family/id_user как bigint -> используем int64
         int64_t id_family_i64 = id_family;
         int64_t id_user_i64 = *IdUserOpt;
-        auto member = co_await db->execSqlCoro(
-            "SELECT 1 FROM family_members WHERE id_family = $1::int8 AND id_user = $2::int8",
+        auto member = co_await db::execCoro(req, db, "family_member_check",
             id_family_i64, id_user_i64);
         if (member.empty()) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -392,17 +462,17 @@ Task<HttpResponsePtr> UserController::InviteToFamily(HttpRequestPtr req, int64_t
         int32_t id_family_int32 = static_cast<int32_t>(id_family);
         int32_t id_user_int32 = static_cast<int32_t>(*IdUserOpt);
 
-        // Добавляем комментарий, чтобы принудить пересоздание prepared statement после смены типов
-        co_await db->execSqlCoro(
-            "/*invite_insert_v2*/ INSERT INTO family_invite (id_family, inviter_id, token, email, created_at) "
-            "VALUES ($1::int4, $2::int4, $3, $4, NOW())",
+        co_await db::execCoro(req, db, "invite_insert_v2",
             id_family_int32,
             id_user_int32,
             token,
             email
         );
         std::string joinUrl = "http://localhost:9000/join-family?token=" + token;
-        LOG_INFO << "Invite to " << email << ": " << joinUrl;
+        // Ссылка содержит токен приглашения и в журнал не пишется
+        SLOG_INFO(kFamilyLog, "family_invite_created")
+            .kv("family", id_family_int32)
+            .kv("inviter", id_user_int32);
         Json::Value res;
         res["message"] = "Invitation sent";
         res["email"] = email;
@@ -430,18 +500,15 @@ Task<HttpResponsePtr> UserController::JoinFamily(HttpRequestPtr req) {
     
     // Пробуем получить данные из JSON
     auto json = req->getJsonObject();
-    LOG_INFO << "[JoinFamily] request received, content-type=" << req->getHeader("Content-Type");
     if (json && json->isMember("token") && json->isMember("email") && json->isMember("password")) {
         token = (*json)["token"].asString();
         email = (*json)["email"].asString();
         password = (*json)["password"].asString();
-        LOG_INFO << "[JoinFamily] got JSON payload token=" << token << " email=" << email;
     } else {
         // Пробуем получить данные из form-data
         token = req->getParameter("token");
         email = req->getParameter("email");
         password = req->getParameter("password");
-        LOG_INFO << "[JoinFamily] got form-data token=" << token << " email=" << email;
         
         if (token.empty() || email.empty() || password.empty()) {
         auto resp = drogon::HttpResponse::newHttpResponse();
@@ -451,10 +518,17 @@ Task<HttpResponsePtr> UserController::JoinFamily(HttpRequestPtr req) {
         }
     }
 
+    // Пауза после неудачных попыток проверяется до обращения к БД и PBKDF2
+    const std::string ip = security::clientIp(req);
+    security::throttle::Attempt attempt(email, ip);
+    if (double wait = attempt.retryAfter(); wait > 0) {
+        co_return throttledResponse(wait);
+    }
+
     auto db = drogon::app().getFastDbClient();
-    LOG_INFO << "[JoinFamily] fetching invite for token=" << token;
-    auto invite = co_await db->execSqlCoro("SELECT id_family, email, used_at from family_invite WHERE token = $1", token);
+    auto invite = co_await db::execCoro(req, db, "invite_by_token", token);
     if (invite.empty()) {
+        attempt.failed();
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k400BadRequest);
         resp->setBody("Invalid token");
@@ -467,32 +541,32 @@ Task<HttpResponsePtr> UserController::JoinFamily(HttpRequestPtr req) {
         co_return resp;
     }
     if (invite[0]["email"].as<std::string>() != email) {
+        attempt.failed();
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k400BadRequest);
         resp->setBody("Email mismatch");
         co_return resp;
     }
-    LOG_INFO << "[JoinFamily] fetching user by email=" << email;
-    auto user = co_await db->execSqlCoro("SELECT id, hashed_password from users WHERE email = $1", email);
+    auto user = co_await db::execCoro(req, db, "user_auth_by_email", email);
     if (user.empty()) {
+        attempt.failed();
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k400BadRequest);
         resp->setBody("User with this email wasn't found");
         co_return resp;
     }
     if (!security::verifyPassword(password, user[0]["hashed_password"].as<std::string>())) {
+        attempt.failed();
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k400BadRequest);
         resp->setBody("Invalid password");
         co_return resp;
     }
+    attempt.succeeded();
     int64_t user_id = user[0]["id"].as<int64_t>();
-    LOG_INFO << "[JoinFamily] user_id=" << user_id << " invite id_family=" << invite[0]["id_family"].as<int64_t>();
     
     // Проверяем, что пользователь не состоит уже в другой семье
-    auto existingMember = co_await db->execSqlCoro(
-        "SELECT id_family FROM family_members WHERE id_user = $1", user_id
-    );
+    auto existingMember = co_await db::execCoro(req, db, "family_id_by_user", user_id);
     if (!existingMember.empty()) {
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k400BadRequest);
@@ -500,11 +574,14 @@ Task<HttpResponsePtr> UserController::JoinFamily(HttpRequestPtr req) {
         co_return resp;
     }
     
-    LOG_INFO << "[JoinFamily] inserting into family_members";
-    co_await db->execSqlCoro("INSERT into family_members(id_family, id_user) VALUES ($1, $2)", 
+    co_await db::execCoro(req, db, "family_member_insert",
         invite[0]["id_family"].as<int64_t>(), user_id);
-    LOG_INFO << "[JoinFamily] marking invite used";
-    co_await db->execSqlCoro("UPDATE family_invite SET used_at = NOW() WHERE token = $1", token);
+    db::categories::invalidateFamilies();
+    db::noteFamilyChange(invite[0]["id_family"].as<int64_t>(), user_id);
+    co_await db::execCoro(req, db, "invite_mark_used", token);
+    SLOG_INFO(kFamilyLog, "family_joined")
+        .kv("family", invite[0]["id_family"].as<int64_t>())
+        .kv("user", user_id);
     std::string jwt = jwt_utils::createToken(user_id, email);
 
     // Если это form-data запрос, перенаправляем на страницу успеха
@@ -553,15 +630,8 @@ Task<HttpResponsePtr> UserController::GetFamily(HttpRequestPtr req) {
             co_return resp;
         }
 
-        auto db = drogon::app().getFastDbClient();
-        auto family = co_await db->execSqlCoro(
-            R"(
-            SELECT f.id, f.name, f.id_owner, f.created_at
-            FROM families f
-            JOIN family_members fm ON f.id = fm.id_family
-            WHERE fm.id_user = $1
-            )", *userIdOpt
-        );
+        auto db = db::readClient(userIdOpt);
+        auto family = co_await db::execCoro(req, db, "family_by_member", *userIdOpt);
 
         if (family.empty()) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -599,11 +669,10 @@ Task<HttpResponsePtr> UserController::GetFamilyMembers(HttpRequestPtr req, int64
             co_return resp;
         }
 
-        auto db = drogon::app().getFastDbClient();
+        auto db = db::readClient(userIdOpt);
         
         // Проверяем, что пользователь является членом семьи
-        auto memberCheck = co_await db->execSqlCoro(
-            "SELECT 1 FROM family_members WHERE id_family = $1 AND id_user = $2",
+        auto memberCheck = co_await db::execCoro(req, db, "family_member_check",
             id_family, *userIdOpt
         );
         
@@ -614,16 +683,7 @@ Task<HttpResponsePtr> UserController::GetFamilyMembers(HttpRequestPtr req, int64
             co_return resp;
         }
 
-        auto members = co_await db->execSqlCoro(
-            R"(
-            SELECT fm.id_user, u.name, u.email, fm.joined_at, f.id_owner
-            FROM family_members fm
-            JOIN users u ON fm.id_user = u.id
-            JOIN families f ON fm.id_family = f.id
-            WHERE fm.id_family = $1
-            ORDER BY fm.joined_at
-            )", id_family
-        );
+        auto members = co_await db::execCoro(req, db, "family_members_list", id_family);
 
         Json::Value result(Json::arrayValue);
         for (const auto &row : members) {
@@ -661,8 +721,7 @@ Task<HttpResponsePtr> UserController::LeaveFamily(HttpRequestPtr req, int64_t id
         auto db = drogon::app().getFastDbClient();
         
         // Проверяем, что пользователь является членом семьи
-        auto memberCheck = co_await db->execSqlCoro(
-            "SELECT 1 FROM family_members WHERE id_family = $1 AND id_user = $2",
+        auto memberCheck = co_await db::execCoro(req, db, "family_member_check",
             id_family, *userIdOpt
         );
         
@@ -674,9 +733,7 @@ Task<HttpResponsePtr> UserController::LeaveFamily(HttpRequestPtr req, int64_t id
         }
 
         // Проверяем, что пользователь не является владельцем
-        auto family = co_await db->execSqlCoro(
-            "SELECT id_owner FROM families WHERE id = $1", id_family
-        );
+        auto family = co_await db::execCoro(req, db, "family_owner", id_family);
         
         if (!family.empty() && family[0]["id_owner"].as<int64_t>() == *userIdOpt) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -686,10 +743,11 @@ Task<HttpResponsePtr> UserController::LeaveFamily(HttpRequestPtr req, int64_t id
         }
 
         // Удаляем пользователя из семьи
-        co_await db->execSqlCoro(
-            "DELETE FROM family_members WHERE id_family = $1 AND id_user = $2",
+        co_await db::execCoro(req, db, "family_member_delete",
             id_family, *userIdOpt
         );
+        db::categories::invalidateFamilies();
+        db::noteFamilyChange(id_family, *userIdOpt);
 
         auto resp = drogon::HttpResponse::newHttpResponse();
         resp->setStatusCode(drogon::k200OK);
@@ -717,9 +775,7 @@ Task<HttpResponsePtr> UserController::RemoveFamilyMember(HttpRequestPtr req, int
         auto db = drogon::app().getFastDbClient();
         
         // Проверяем, что запрашивающий является владельцем семьи
-        auto family = co_await db->execSqlCoro(
-            "SELECT id_owner FROM families WHERE id = $1", id_family
-        );
+        auto family = co_await db::execCoro(req, db, "family_owner", id_family);
         
         if (family.empty()) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -744,10 +800,11 @@ Task<HttpResponsePtr> UserController::RemoveFamilyMember(HttpRequestPtr req, int
         }
 
         // Удаляем пользователя из семьи
-        auto result = co_await db->execSqlCoro(
-            "DELETE FROM family_members WHERE id_family = $1 AND id_user = $2",
+        auto result = co_await db::execCoro(req, db, "family_member_delete",
             id_family, user_id
         );
+        db::categories::invalidateFamilies();
+        db::noteFamilyChange(id_family, user_id);
 
         if (result.affectedRows() == 0) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -779,12 +836,10 @@ Task<HttpResponsePtr> UserController::GetFamilyInvites(HttpRequestPtr req) {
             co_return resp;
         }
 
-        auto db = drogon::app().getFastDbClient();
+        auto db = db::readClient(userIdOpt);
         
         // Получаем email пользователя
-        auto user = co_await db->execSqlCoro(
-            "SELECT email FROM users WHERE id = $1", *userIdOpt
-        );
+        auto user = co_await db::execCoro(req, db, "user_email_by_id", *userIdOpt);
         
         if (user.empty()) {
             auto resp = drogon::HttpResponse::newHttpResponse();
@@ -796,18 +851,7 @@ Task<HttpResponsePtr> UserController::GetFamilyInvites(HttpRequestPtr req) {
         std::string email = user[0]["email"].as<std::string>();
         
         // Получаем приглашения для этого email
-        auto invites = co_await db->execSqlCoro(
-            R"(
-            SELECT fi.id, fi.id_family, fi.email, fi.created_at, fi.token,
-                   f.name as family_name, u.name as inviter_name
-            FROM family_invite fi
-            JOIN families f ON fi.id_family = f.id
-            JOIN users u ON fi.inviter_id = u.id
-            WHERE fi.email = $1
-            AND fi.used_at IS NULL
-            ORDER BY fi.created_at DESC
-            )", email
-        );
+        auto invites = co_await db::execCoro(req, db, "pending_invites_by_email", email);
 
         Json::Value result(Json::arrayValue);
         for (const auto &row : invites) {
@@ -848,7 +892,7 @@ void UserController::ShowJoinFamily(const drogon::HttpRequestPtr& req,
 
     auto db = drogon::app().getFastDbClient();
     db->execSqlAsync(
-        "SELECT id_family, email, used_at FROM family_invite WHERE token = $1",
+        db::sql("invite_by_token"),
         [token, callback](const drogon::orm::Result &invite) {
             bool hasError = false;
             std::string errorMessage;
@@ -954,9 +998,7 @@ void UserController::ShowCreateFamilyPage(const drogon::HttpRequestPtr& req,
     auto userIdOpt = jwt_utils::getUserIdFromRequest(req);
     if (userIdOpt) {
         auto db = drogon::app().getFastDbClient();
-        auto family = db->execSqlSync(
-            "SELECT 1 FROM family_members WHERE id_user = $1", *userIdOpt
-        );
+        auto family = db->execSqlSync(db::sql("family_membership_exists"), *userIdOpt);
         if (!family.empty()) {
             hasError = true;
             errorMessage = "Вы уже состоите в семье. Пожалуйста, покиньте текущую семью перед созданием новой.";
@@ -1075,12 +1117,7 @@ void UserController::ShowFamilyMembersPage(const drogon::HttpRequestPtr& req,
     }
     auto db = drogon::app().getFastDbClient();
     db->execSqlAsync(
-        R"(
-        SELECT f.id, f.name, f.id_owner
-        FROM families f
-        JOIN family_members fm ON f.id = fm.id_family
-        WHERE fm.id_user = $1
-        )",
+        db::sql("family_by_member"),
         [callback, userIdOpt](const drogon::orm::Result &family) {
             std::string html = R"(<!DOCTYPE html>
 <html>
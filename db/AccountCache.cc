@@ -0,0 +1,99 @@
+#include "AccountCache.h"
+#include <drogon/drogon.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "db/CacheBus.h"
+#include "db/DataBase.h"
+
+using drogon::HttpRequestPtr;
+using drogon::Task;
+using db::accounts::AccountOwner;
+
+namespace {
+
+// При переполнении таблица очищается целиком: запись дёшево перечитать
+constexpr size_t kMaxEntries = 100000;
+
+std::mutex gMutex;
+std::unordered_map<int64_t, AccountOwner> gOwners;
+
+// Поколение кэша: загрузка, начатая до сброса, в кэш не попадает
+std::atomic<uint64_t> gGeneration{0};
+
+}
+
+Task<std::optional<AccountOwner>> db::accounts::owner(HttpRequestPtr req,
+                                                     int64_t accountId,
+                                                     drogon::orm::DbClientPtr client) {
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        auto it = gOwners.find(accountId);
+        if (it != gOwners.end()) {
+            co_return it->second;
+        }
+    }
+
+    const uint64_t generation = gGeneration.load();
+    // Снимок транзакции вызывающего мог быть взят до инвалидации, прошедшей
+    // уже после чтения generation: такой результат годится только для этого
+    // запроса и в кэш не попадает
+    const bool cacheable = !client;
+    if (!client) {
+        client = drogon::app().getFastDbClient();
+    }
+    auto rows = co_await db::execCoro(req, client, "account_owner", accountId);
+    if (rows.empty()) {
+        co_return std::nullopt;
+    }
+    AccountOwner info;
+    info.id = accountId;
+    info.idUser = rows[0]["id_user"].as<int64_t>();
+    info.isFamily = !rows[0]["is_family"].isNull() && rows[0]["is_family"].as<bool>();
+    if (!cacheable) {
+        co_return info;
+    }
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gGeneration.load() == generation) {
+        if (gOwners.size() >= kMaxEntries) {
+            gOwners.clear();
+        }
+        gOwners[accountId] = info;
+    }
+    co_return info;
+}
+
+void db::accounts::evict(int64_t accountId) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    ++gGeneration;
+    gOwners.erase(accountId);
+}
+
+void db::accounts::evictUser(int64_t userId) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    ++gGeneration;
+    for (auto it = gOwners.begin(); it != gOwners.end();) {
+        if (it->second.idUser == userId) {
+            it = gOwners.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void db::accounts::evictAll() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    ++gGeneration;
+    gOwners.clear();
+}
+
+void db::accounts::invalidate(int64_t accountId) {
+    evict(accountId);
+    db::cacheBus::publish("acc:" + std::to_string(accountId));
+}
+
+void db::accounts::invalidateUser(int64_t userId) {
+    evictUser(userId);
+    db::cacheBus::publish("acc_user:" + std::to_string(userId));
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <drogon/HttpRequest.h>
+#include <drogon/orm/DbClient.h>
+#include <drogon/utils/coroutine.h>
+
+namespace db::accounts {
+
+// Неизменяемые поля счёта, нужные для проверки прав доступа.
+// Баланс сюда не входит и всегда читается из БД.
+struct AccountOwner {
+    int64_t id;
+    int64_t idUser;
+    bool isFamily;
+};
+
+// Владелец и область счёта; std::nullopt, если счёта нет.
+// При промахе читается с основного сервера, а внутри db::inTransaction —
+// через переданную транзакцию client: второе соединение из пула на время
+// транзакции при одновременных записях исчерпало бы пул. Прочитанное через
+// client в кэш не попадает.
+drogon::Task<std::optional<AccountOwner>> owner(drogon::HttpRequestPtr req,
+                                                int64_t accountId,
+                                                drogon::orm::DbClientPtr client = nullptr);
+
+// Сброс записей в этом экземпляре и оповещение остальных через db::cacheBus.
+
+// Счёт изменён или удалён
+void invalidate(int64_t accountId);
+
+// Пользователь удалён вместе со своими счетами
+void invalidateUser(int64_t userId);
+
+// Сброс только в этом экземпляре (по сообщениям других экземпляров)
+void evict(int64_t accountId);
+void evictUser(int64_t userId);
+void evictAll();
+
+}
@@ -0,0 +1,184 @@
+#include "Admission.h"
+#include <drogon/drogon.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "db/DbConfig.h"
+#include "db/QueryMetrics.h"
+#include "db/ReadRouting.h"
+#include "utils/JwtUtils.h"
+
+namespace {
+
+// Пул соединений клиента из db_clients и число занявших его запросов
+struct Pool {
+    std::string name;
+    int64_t connections = 1;
+    std::atomic<int64_t> inFlight{0};
+};
+
+struct AdmissionConfig {
+    // Допустимая очередь сверх числа соединений, в долях от него
+    double readQueuePerConnection = 2;
+    double writeQueuePerConnection = 4;
+    int retryAfterSec = 1;
+    // Маршруты без запросов к БД или с долгой работой CPU (PBKDF2 при входе):
+    // место в пуле простаивало бы и завышало очередь
+    std::vector<std::string> exemptPaths{"/metrics", "/api/admin/", "/api/auth/login",
+                                         "/ui/", "/auth/", "/family/", "/join-family"};
+    // Точные шаблоны маршрутов, которые не выразить префиксом
+    std::vector<std::string> exemptRoutes{"/", "/home", "/accounts/create"};
+};
+
+AdmissionConfig gConfig;
+// Заполняется в init и дальше только читается
+std::unordered_map<std::string, std::unique_ptr<Pool>> gPools;
+
+const std::string kSlotAttribute = "admission_slot";
+
+void report(const Pool &pool, int64_t inFlight) {
+    db::metrics::observePool(pool.name, inFlight,
+                             std::max<int64_t>(0, inFlight - pool.connections));
+}
+
+// Место в пуле; освобождается при отправке ответа или, если ответа не было,
+// вместе с запросом, но не раньше завершения удерживающей его работы
+// (db::admission::hold)
+struct Slot {
+    explicit Slot(Pool *pool) : pool_(pool) {}
+    ~Slot() { report(*pool_, --pool_->inFlight); }
+
+    Slot(const Slot &) = delete;
+    Slot &operator=(const Slot &) = delete;
+
+  private:
+    Pool *pool_;
+};
+
+bool isRead(const drogon::HttpRequestPtr &req) {
+    return req->method() == drogon::Get || req->method() == drogon::Head ||
+           req->method() == drogon::Options;
+}
+
+bool isExempt(const drogon::HttpRequestPtr &req) {
+    for (const auto &prefix : gConfig.exemptPaths) {
+        if (req->path().rfind(prefix, 0) == 0) {
+            return true;
+        }
+    }
+    const std::string_view route = req->getMatchedPathPattern().empty()
+                                       ? std::string_view(req->path())
+                                       : req->getMatchedPathPattern();
+    for (const auto &exact : gConfig.exemptRoutes) {
+        if (route == exact) {
+            return true;
+        }
+    }
+    return false;
+}
+
+drogon::HttpResponsePtr overloaded() {
+    auto resp = drogon::HttpResponse::newHttpResponse();
+    resp->setStatusCode(drogon::k503ServiceUnavailable);
+    resp->addHeader("Retry-After", std::to_string(gConfig.retryAfterSec));
+    resp->setBody("Service is overloaded, retry later");
+    return resp;
+}
+
+void addPool(const std::string &configPath, const std::string &name) {
+    if (name.empty() || gPools.count(name)) {
+        return;
+    }
+    auto pool = std::make_unique<Pool>();
+    pool->name = name;
+    try {
+        pool->connections = static_cast<int64_t>(db::connectionCount(configPath, name));
+    } catch (const std::exception &e) {
+        LOG_ERROR << "Admission control: " << e.what();
+        return;
+    }
+    LOG_INFO << "Admission control: pool '" << name << "' with "
+             << pool->connections << " connections";
+    gPools.emplace(name, std::move(pool));
+}
+
+}
+
+void db::admission::init(const std::string &configPath) {
+    const auto &custom = drogon::app().getCustomConfig();
+    const auto &cfg = custom["admission"];
+    if (!cfg.isObject() || !cfg.get("enabled", false).asBool()) {
+        return;
+    }
+    gConfig.readQueuePerConnection =
+        cfg.get("read_queue_per_connection", gConfig.readQueuePerConnection).asDouble();
+    gConfig.writeQueuePerConnection =
+        cfg.get("write_queue_per_connection", gConfig.writeQueuePerConnection).asDouble();
+    gConfig.retryAfterSec = cfg.get("retry_after_sec", gConfig.retryAfterSec).asInt();
+    if (cfg.isMember("exempt_paths")) {
+        gConfig.exemptPaths.clear();
+        for (const auto &path : cfg["exempt_paths"]) {
+            gConfig.exemptPaths.push_back(path.asString());
+        }
+    }
+    if (cfg.isMember("exempt_routes")) {
+        gConfig.exemptRoutes.clear();
+        for (const auto &route : cfg["exempt_routes"]) {
+            gConfig.exemptRoutes.push_back(route.asString());
+        }
+    }
+
+    addPool(configPath, "default");
+    addPool(configPath, custom["read_replica"].get("client", "").asString());
+    if (gPools.empty()) {
+        return;
+    }
+
+    drogon::app().registerPreHandlingAdvice(
+        [](const drogon::HttpRequestPtr &req,
+           drogon::AdviceCallback &&respond,
+           drogon::AdviceChainCallback &&next) {
+            if (isExempt(req)) {
+                next();
+                return;
+            }
+            const bool read = isRead(req);
+            const std::string poolName =
+                read ? db::readClientName(jwt_utils::getUserIdFromRequest(req)) : "default";
+            auto it = gPools.find(poolName);
+            if (it == gPools.end()) {
+                next();
+                return;
+            }
+            Pool &pool = *it->second;
+
+            const int64_t inFlight = ++pool.inFlight;
+            const double perConnection =
+                read ? gConfig.readQueuePerConnection : gConfig.writeQueuePerConnection;
+            const auto budget = static_cast<int64_t>(pool.connections * perConnection);
+            if (inFlight - pool.connections > budget) {
+                report(pool, --pool.inFlight);
+                db::metrics::observeShed(pool.name, read ? "read" : "write");
+                respond(overloaded());
+                return;
+            }
+            report(pool, inFlight);
+            req->attributes()->insert(kSlotAttribute, std::make_shared<Slot>(&pool));
+            next();
+        });
+
+    drogon::app().registerPreSendingAdvice(
+        [](const drogon::HttpRequestPtr &req, const drogon::HttpResponsePtr &) {
+            req->attributes()->erase(kSlotAttribute);
+        });
+}
+
+std::shared_ptr<void> db::admission::hold(const drogon::HttpRequestPtr &req) {
+    if (!req || !req->attributes()->find(kSlotAttribute)) {
+        return nullptr;
+    }
+    return req->attributes()->get<std::shared_ptr<Slot>>(kSlotAttribute);
+}
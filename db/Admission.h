@@ -0,0 +1,25 @@
+#pragma once
+#include <drogon/HttpRequest.h>
+#include <memory>
+#include <string>
+
+// Контроль допуска по пулам соединений с БД. Каждый запрос к API занимает
+// место в пуле, с которым будет работать: чтения — в пуле db::readClientName,
+// изменения — в default. Когда запросов в пуле больше, чем соединений,
+// остальные ждут в очереди клиента Drogon; если очередь превышает бюджет,
+// новые запросы сразу получают 503 с Retry-After вместо ожидания таймаута БД.
+// Бюджет очереди для чтений меньше, поэтому под нагрузкой первыми
+// отклоняются чтения. HTML-страницы, вход и /api/admin/ места не занимают.
+namespace db::admission {
+
+// Настраивает пулы по custom_config.admission и секции db_clients из
+// configPath и регистрирует advices. Вызывается до app().run().
+void init(const std::string &configPath);
+
+// Место запроса req в пуле (nullptr, если запрос его не занимал). Пока
+// возвращённый указатель жив, место не освобождается, даже если ответ уже
+// отправлен: так работа, пережившая ответ (запрос к БД после таймаута
+// ожидания), остаётся в учёте пула.
+std::shared_ptr<void> hold(const drogon::HttpRequestPtr &req);
+
+}
@@ -0,0 +1,114 @@
+#include "CacheBus.h"
+#include <drogon/drogon.h>
+#include <drogon/orm/DbListener.h>
+#include <cstdlib>
+#include <memory>
+#include "db/AccountCache.h"
+#include "db/CategoryCache.h"
+#include "db/DbConfig.h"
+#include "db/Statements.h"
+
+namespace {
+
+std::string gChannel = "finance_cache";
+bool gEnabled = false;
+std::shared_ptr<drogon::orm::DbListener> gListener;
+
+// Разбирает "<prefix>:<a>[:<b>]" на числовые аргументы
+bool parseIds(const std::string &rest, int64_t &first, int64_t *second) {
+    char *end = nullptr;
+    first = std::strtoll(rest.c_str(), &end, 10);
+    if (end == rest.c_str()) {
+        return false;
+    }
+    if (!second) {
+        return *end == '\0';
+    }
+    if (*end != ':') {
+        return false;
+    }
+    const char *next = end + 1;
+    *second = std::strtoll(next, &end, 10);
+    return end != next && *end == '\0';
+}
+
+// Сброс всех кэшей: подстраховка на случай потерянных уведомлений
+// (например, пока слушающее соединение переподключалось)
+void evictAll() {
+    db::categories::evictAll();
+    db::accounts::evictAll();
+}
+
+}
+
+void db::cacheBus::init(const std::string &configPath) {
+    const auto &cfg = drogon::app().getCustomConfig()["cache_bus"];
+    if (!cfg.isObject() || !cfg.get("enabled", false).asBool()) {
+        return;
+    }
+    gChannel = cfg.get("channel", gChannel).asString();
+    const double maxStalenessSec = cfg.get("max_staleness_sec", 300).asDouble();
+
+    std::string connInfo;
+    try {
+        connInfo = db::connectionInfo(configPath);
+    } catch (const std::exception &e) {
+        LOG_ERROR << "Cache bus disabled: " << e.what();
+        return;
+    }
+    gEnabled = true;
+
+    drogon::app().registerBeginningAdvice([connInfo, maxStalenessSec]() {
+        gListener = drogon::orm::DbListener::newPgListener(connInfo);
+        if (!gListener) {
+            LOG_ERROR << "Cache bus: failed to create Postgres listener";
+            gEnabled = false;
+            return;
+        }
+        gListener->listen(gChannel, [](const std::string & /*channel*/, const std::string &message) {
+            apply(message);
+        });
+        if (maxStalenessSec > 0) {
+            drogon::app().getLoop()->runEvery(maxStalenessSec, []() { evictAll(); });
+        }
+        LOG_INFO << "Cache bus listening on channel '" << gChannel << "'";
+    });
+}
+
+void db::cacheBus::publish(const std::string &message) {
+    if (!gEnabled) {
+        return;
+    }
+    auto client = drogon::app().getFastDbClient();
+    client->execSqlAsync(
+        db::sql("cache_notify"),
+        [](const drogon::orm::Result &) {},
+        [message](const drogon::orm::DrogonDbException &e) {
+            LOG_ERROR << "Cache bus: failed to publish '" << message << "': " << e.base().what();
+        },
+        gChannel, message);
+}
+
+void db::cacheBus::apply(const std::string &message) {
+    auto colon = message.find(':');
+    std::string kind = message.substr(0, colon);
+    std::string rest = colon == std::string::npos ? "" : message.substr(colon + 1);
+    int64_t a = 0;
+    int64_t b = 0;
+
+    if (kind == "cat" && parseIds(rest, a, &b)) {
+        db::categories::evict(a, b);
+    } else if (kind == "cat_user" && parseIds(rest, a, nullptr)) {
+        db::categories::evictUser(a);
+    } else if (kind == "cat_families") {
+        db::categories::evictFamilies();
+    } else if (kind == "acc" && parseIds(rest, a, nullptr)) {
+        db::accounts::evict(a);
+    } else if (kind == "acc_user" && parseIds(rest, a, nullptr)) {
+        db::accounts::evictUser(a);
+    } else {
+        // Неизвестное сообщение (например, от более новой версии) — сбрасываем всё
+        LOG_WARN << "Cache bus: unknown message '" << message << "', evicting all";
+        evictAll();
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+
+// Шина инвалидации кэшей между экземплярами приложения поверх
+// Postgres LISTEN/NOTIFY. Изменения публикуются через pg_notify,
+// каждый экземпляр слушает канал на отдельном соединении и сбрасывает
+// соответствующие записи (db::categories, db::accounts).
+namespace db::cacheBus {
+
+// Подписывается на канал custom_config.cache_bus.channel после старта
+// приложения. Вызывается до app().run().
+void init(const std::string &configPath);
+
+// Отправляет сообщение остальным экземплярам (асинхронно, без ожидания)
+void publish(const std::string &message);
+
+// Применяет полученное сообщение к кэшам этого экземпляра
+void apply(const std::string &message);
+
+}
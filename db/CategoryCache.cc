@@ -0,0 +1,194 @@
+#include "CategoryCache.h"
+#include <drogon/drogon.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "db/CacheBus.h"
+#include "db/DataBase.h"
+#include "db/SingleFlight.h"
+
+using drogon::HttpRequestPtr;
+using drogon::Task;
+using drogon::orm::Result;
+using db::categories::CategoryInfo;
+using db::categories::CategoryList;
+
+namespace {
+
+// При переполнении таблица очищается целиком: категории дёшево перечитать
+constexpr size_t kMaxEntries = 50000;
+
+std::mutex gMutex;
+std::unordered_map<int64_t, CategoryInfo> gById;
+std::unordered_map<int64_t, std::shared_ptr<const CategoryList>> gPersonal;
+std::unordered_map<int64_t, std::shared_ptr<const CategoryList>> gFamily;
+
+// Поколение кэша: растёт при каждом сбросе. Результат загрузки, начатой до
+// сброса, в кэш не попадает.
+std::atomic<uint64_t> gGeneration{0};
+
+CategoryInfo fromRow(const drogon::orm::Row &row) {
+    CategoryInfo info;
+    info.id = row["id"].as<int64_t>();
+    info.idUser = row["id_user"].as<int64_t>();
+    info.name = row["name"].as<std::string>();
+    info.type = row["type"].as<std::string>();
+    info.isFamily = !row["is_family"].isNull() && row["is_family"].as<bool>();
+    return info;
+}
+
+std::shared_ptr<const CategoryList> fromResult(const Result &rows) {
+    auto list = std::make_shared<CategoryList>();
+    list->reserve(rows.size());
+    for (const auto &row : rows) {
+        list->push_back(fromRow(row));
+    }
+    return list;
+}
+
+template <typename Map, typename Value>
+void store(Map &map, int64_t key, Value value, uint64_t generation) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gGeneration.load() != generation) {
+        return;
+    }
+    if (map.size() >= kMaxEntries) {
+        map.clear();
+    }
+    map[key] = std::move(value);
+}
+
+template <typename Map>
+std::optional<typename Map::mapped_type> lookup(const Map &map, int64_t key) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    auto it = map.find(key);
+    if (it == map.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+// Загрузка списка области; одновременные промахи по одной области
+// объединяются в один запрос
+Task<std::shared_ptr<const CategoryList>> loadList(
+    HttpRequestPtr req,
+    std::unordered_map<int64_t, std::shared_ptr<const CategoryList>> &map,
+    std::string scope,
+    std::string statement,
+    int64_t key) {
+    const uint64_t generation = gGeneration.load();
+    auto client = drogon::app().getFastDbClient();
+    auto rows = co_await db::singleFlight(
+        "category_cache|" + scope + "|" + std::to_string(generation),
+        [req, client, statement, key]() {
+            return db::execCoro(req, client, statement, key);
+        });
+    auto list = fromResult(rows);
+    store(map, key, list, generation);
+    co_return list;
+}
+
+}
+
+Task<std::optional<CategoryInfo>> db::categories::find(HttpRequestPtr req,
+                                                      int64_t categoryId,
+                                                      drogon::orm::DbClientPtr client) {
+    if (auto cached = lookup(gById, categoryId)) {
+        co_return cached;
+    }
+    const uint64_t generation = gGeneration.load();
+    // Строка из снимка транзакции вызывающего может быть старше generation,
+    // поэтому кэшируются только чтения вне транзакции
+    const bool cacheable = !client;
+    if (!client) {
+        client = drogon::app().getFastDbClient();
+    }
+    auto rows = co_await db::execCoro(req, client, "category_by_id", categoryId);
+    if (rows.empty()) {
+        co_return std::nullopt;
+    }
+    auto info = fromRow(rows[0]);
+    if (cacheable) {
+        store(gById, categoryId, info, generation);
+    }
+    co_return info;
+}
+
+Task<std::shared_ptr<const CategoryList>> db::categories::personal(HttpRequestPtr req, int64_t userId) {
+    if (auto cached = lookup(gPersonal, userId)) {
+        co_return *cached;
+    }
+    co_return co_await loadList(req, gPersonal, "user:" + std::to_string(userId),
+                                "personal_categories", userId);
+}
+
+Task<std::shared_ptr<const CategoryList>> db::categories::family(HttpRequestPtr req, int64_t familyId) {
+    if (auto cached = lookup(gFamily, familyId)) {
+        co_return *cached;
+    }
+    co_return co_await loadList(req, gFamily, "family:" + std::to_string(familyId),
+                                "family_categories_v2", familyId);
+}
+
+Json::Value db::categories::toJson(const CategoryInfo &category) {
+    Json::Value json;
+    json["id"] = (Json::Int64)category.id;
+    json["id_user"] = (Json::Int64)category.idUser;
+    json["name"] = category.name;
+    json["type"] = category.type;
+    json["is_family"] = category.isFamily;
+    return json;
+}
+
+void db::categories::evict(int64_t categoryId, int64_t ownerId) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    ++gGeneration;
+    gById.erase(categoryId);
+    gPersonal.erase(ownerId);
+    // Семью владельца здесь не знаем; категории меняются редко,
+    // поэтому сбрасываем семейные списки целиком
+    gFamily.clear();
+}
+
+void db::categories::evictUser(int64_t userId) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    ++gGeneration;
+    for (auto it = gById.begin(); it != gById.end();) {
+        if (it->second.idUser == userId) {
+            it = gById.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    gPersonal.erase(userId);
+    gFamily.clear();
+}
+
+void db::categories::evictFamilies() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    ++gGeneration;
+    gFamily.clear();
+}
+
+void db::categories::evictAll() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    ++gGeneration;
+    gById.clear();
+    gPersonal.clear();
+    gFamily.clear();
+}
+
+void db::categories::invalidate(int64_t categoryId, int64_t ownerId) {
+    evict(categoryId, ownerId);
+    db::cacheBus::publish("cat:" + std::to_string(categoryId) + ":" + std::to_string(ownerId));
+}
+
+void db::categories::invalidateUser(int64_t userId) {
+    evictUser(userId);
+    db::cacheBus::publish("cat_user:" + std::to_string(userId));
+}
+
+void db::categories::invalidateFamilies() {
+    evictFamilies();
+    db::cacheBus::publish("cat_families");
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <drogon/HttpRequest.h>
+#include <drogon/orm/DbClient.h>
+#include <drogon/utils/coroutine.h>
+#include <jsoncpp/json/json.h>
+
+namespace db::categories {
+
+// Категория в кэше
+struct CategoryInfo {
+    int64_t id;
+    int64_t idUser;
+    std::string name;
+    std::string type;
+    bool isFamily;
+};
+
+using CategoryList = std::vector<CategoryInfo>;
+
+// Кэш категорий по областям: отдельная категория по id, личные категории
+// пользователя и семейные категории семьи. Заполняется при первом обращении
+// с основного сервера (не с реплики), сбрасывается при изменениях категорий
+// и состава семьи.
+
+// Категория по id; std::nullopt, если её нет. Внутри db::inTransaction
+// промах читается через транзакцию client, а не через второе соединение,
+// и такой результат не кэшируется.
+drogon::Task<std::optional<CategoryInfo>> find(drogon::HttpRequestPtr req,
+                                               int64_t categoryId,
+                                               drogon::orm::DbClientPtr client = nullptr);
+
+// Личные категории пользователя (is_family = false)
+drogon::Task<std::shared_ptr<const CategoryList>> personal(drogon::HttpRequestPtr req, int64_t userId);
+
+// Семейные категории всех членов семьи (is_family = true)
+drogon::Task<std::shared_ptr<const CategoryList>> family(drogon::HttpRequestPtr req, int64_t familyId);
+
+Json::Value toJson(const CategoryInfo &category);
+
+// Сброс записей в этом экземпляре и оповещение остальных через db::cacheBus.
+
+// Категория создана, изменена или удалена
+void invalidate(int64_t categoryId, int64_t ownerId);
+
+// Пользователь удалён: вместе с ним каскадно удалены его категории
+void invalidateUser(int64_t userId);
+
+// Изменился состав какой-либо семьи
+void invalidateFamilies();
+
+// Сброс только в этом экземпляре (по сообщениям других экземпляров)
+void evict(int64_t categoryId, int64_t ownerId);
+void evictUser(int64_t userId);
+void evictFamilies();
+void evictAll();
+
+}
@@ -1,6 +1,21 @@
 #pragma once
 #include <drogon/orm/DbClient.h>
 #include <drogon/drogon.h>
+#include <trantor/net/EventLoop.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "db/Admission.h"
+#include "db/Deadline.h"
+#include "db/Statements.h"
+#include "db/QueryMetrics.h"
+#include "db/Tracing.h"
+#include "plugins/SlowQueryLog.h"
 
 namespace db {
 
@@ -9,4 +24,177 @@ inline drogon::orm::DbClientPtr getDbClient() {
     return client;
 }
 
-}
\ No newline at end of file
+namespace detail {
+
+// Параметр запроса для журнала: числа пишем как есть, строки (email, токены,
+// пароли) маскируем, оставляя только длину
+template <typename T>
+std::string describeParam(const T &value) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        return std::to_string(value);
+    } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+        return "<redacted:" + std::to_string(std::string_view(value).size()) + ">";
+    } else {
+        return "<redacted>";
+    }
+}
+
+inline std::string describeRoute(const drogon::HttpRequestPtr &req) {
+    if (!req) {
+        return "-";
+    }
+    return std::string(req->methodString()) + " " + req->path();
+}
+
+template <typename... Arguments>
+void reportSlowQuery(finance::SlowQueryLog &log,
+                     const drogon::HttpRequestPtr &req,
+                     const drogon::orm::DbClientPtr &client,
+                     std::string_view name,
+                     std::chrono::steady_clock::duration elapsed,
+                     const Arguments &...args) {
+    log.logSlowQuery(name, describeRoute(req), elapsed,
+                     std::vector<std::string>{describeParam(args)...});
+    if (!log.shouldExplain(name)) {
+        return;
+    }
+    // План снимаем асинхронно, не задерживая ответ. Запрос внутри транзакции
+    // объясняется на отдельном соединении и без ANALYZE: в самой транзакции
+    // EXPLAIN задержал бы COMMIT, а его ошибка откатила бы транзакцию;
+    // ANALYZE на другом соединении ждал бы блокировок этой транзакции.
+    const bool inTransaction = std::dynamic_pointer_cast<drogon::orm::Transaction>(client) != nullptr;
+    auto explainClient = inTransaction ? drogon::app().getFastDbClient() : client;
+    std::string statement(name);
+    explainClient->execSqlAsync(
+        finance::SlowQueryLog::explainSql(name, !inTransaction),
+        [statement](const drogon::orm::Result &plan) {
+            if (auto *slowLog = finance::SlowQueryLog::instance()) {
+                slowLog->logExplain(statement, plan);
+            }
+        },
+        [statement](const drogon::orm::DrogonDbException &e) {
+            if (auto *slowLog = finance::SlowQueryLog::instance()) {
+                slowLog->logExplainError(statement, e);
+            }
+        },
+        args...);
+}
+
+// Ожидание запроса не дольше timeoutMs: по истечении корутина получает
+// drogon::orm::TimeoutError, а поздний результат отбрасывается. Сам запрос
+// на сервере ограничивает statement_timeout соединения (connect_options
+// в db_clients). hold (место запроса в пуле, db::admission::hold) живёт до
+// завершения запроса на сервере, а не до ответа клиенту: брошенный запрос
+// продолжает занимать соединение и учитывается контролем допуска.
+struct BoundedAwaiter : drogon::CallbackAwaiter<drogon::orm::Result> {
+    using Start = std::function<void(std::function<void(const drogon::orm::Result &)>,
+                                     std::function<void(const drogon::orm::DrogonDbException &)>)>;
+
+    BoundedAwaiter(int64_t timeoutMs, Start start, std::shared_ptr<void> hold = nullptr)
+        : timeoutMs_(timeoutMs), start_(std::move(start)), hold_(std::move(hold)) {}
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        auto *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        (loop ? loop : drogon::app().getLoop())
+            ->runAfter(static_cast<double>(timeoutMs_) / 1000.0, [this, handle, done]() {
+                if (done->exchange(true)) {
+                    return;
+                }
+                setException(std::make_exception_ptr(
+                    drogon::orm::TimeoutError("Query exceeded the request deadline")));
+                handle.resume();
+            });
+        start_(
+            [this, handle, done, hold = hold_](const drogon::orm::Result &result) {
+                if (done->exchange(true)) {
+                    return;
+                }
+                setValue(result);
+                handle.resume();
+            },
+            [this, handle, done, hold = hold_](const drogon::orm::DrogonDbException &) {
+                if (done->exchange(true)) {
+                    return;
+                }
+                setException(std::current_exception());
+                handle.resume();
+            });
+    }
+
+  private:
+    int64_t timeoutMs_;
+    Start start_;
+    std::shared_ptr<void> hold_;
+};
+
+// Запрос с ограничением времени на стороне клиента: один запрос без
+// BEGIN/SET LOCAL/COMMIT, то есть без лишних обращений к серверу
+template <typename... Arguments>
+drogon::Task<drogon::orm::Result> execBounded(drogon::orm::DbClientPtr client,
+                                              int64_t timeoutMs,
+                                              std::shared_ptr<void> hold,
+                                              std::string_view name,
+                                              const Arguments &...args) {
+    const std::string &statement = sql(name);
+    co_return co_await BoundedAwaiter(
+        timeoutMs,
+        [client, &statement, args...](auto onResult, auto onError) {
+            client->execSqlAsync(statement, std::move(onResult), std::move(onError), args...);
+        },
+        std::move(hold));
+}
+
+// Учитывает срок запроса req (db::deadline): после истечения запрос не
+// отправляется, ожидание тяжёлых запросов ограничивается оставшимся временем.
+// Внутри db::inTransaction statement_timeout уже задан для всей транзакции.
+template <typename... Arguments>
+drogon::Task<drogon::orm::Result> execWithDeadline(const drogon::HttpRequestPtr &req,
+                                                   const drogon::orm::DbClientPtr &client,
+                                                   std::string_view name,
+                                                   const Arguments &...args) {
+    auto timeoutMs = deadline::remainingMs(req);
+    if (timeoutMs && deadline::isBounded(name) &&
+        !std::dynamic_pointer_cast<drogon::orm::Transaction>(client)) {
+        co_return co_await execBounded(client, *timeoutMs, admission::hold(req), name, args...);
+    }
+    co_return co_await client->execSqlCoro(sql(name), args...);
+}
+
+}
+
+// Выполняет зарегистрированный запрос по имени (см. db/Statements.cc),
+// записывает его длительность, число строк и ошибки в /metrics, а медленные
+// запросы — в журнал SlowQueryLog с маршрутом запроса req. Соблюдает срок
+// запроса req (db/Deadline.h). Если запрос req в выборке трассировки, время
+// ожидания попадает в его трассу (db/Tracing.h).
+template <typename... Arguments>
+drogon::Task<drogon::orm::Result> execCoro(drogon::HttpRequestPtr req,
+                                           drogon::orm::DbClientPtr client,
+                                           std::string_view name,
+                                           Arguments... args) {
+    tracing::Span span(req, name);
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        auto result = co_await detail::execWithDeadline(req, client, name, args...);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        span.setRows(result.empty() ? static_cast<int64_t>(result.affectedRows())
+                                    : static_cast<int64_t>(result.size()));
+        span.finish();
+        metrics::observeQuery(name, elapsed, result);
+        auto *slowLog = finance::SlowQueryLog::instance();
+        if (slowLog && slowLog->isSlow(elapsed)) {
+            detail::reportSlowQuery(*slowLog, req, client, name, elapsed, args...);
+        }
+        co_return result;
+    } catch (const std::exception &e) {
+        span.setError(e.what());
+        metrics::observeQueryError(name, std::chrono::steady_clock::now() - start);
+        throw;
+    } catch (...) {
+        metrics::observeQueryError(name, std::chrono::steady_clock::now() - start);
+        throw;
+    }
+}
+
+}
@@ -0,0 +1,96 @@
+#include "DbConfig.h"
+#include <jsoncpp/json/json.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Значение вида "$NAME" берётся из переменной окружения NAME
+std::string expandEnv(const std::string &value) {
+    if (value.size() > 1 && value[0] == '$') {
+        if (const char *env = std::getenv(value.c_str() + 1)) {
+            return env;
+        }
+    }
+    return value;
+}
+
+// Экранирование значения для строки подключения libpq
+std::string quoteConnValue(const std::string &value) {
+    std::string out = "'";
+    for (char c : value) {
+        if (c == '\'' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    out += "'";
+    return out;
+}
+
+Json::Value loadConfig(const std::string &configPath) {
+    std::ifstream in(configPath);
+    if (!in) {
+        throw std::runtime_error("Cannot open config " + configPath);
+    }
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    if (!Json::parseFromStream(builder, in, &root, &errs)) {
+        throw std::runtime_error("Cannot parse config " + configPath + ": " + errs);
+    }
+    return root;
+}
+
+Json::Value findClient(const Json::Value &root,
+                       const std::string &configPath,
+                       const std::string &clientName) {
+    for (const auto &cfg : root["db_clients"]) {
+        if (cfg.get("name", "default").asString() == clientName) {
+            return cfg;
+        }
+    }
+    throw std::runtime_error("db client '" + clientName + "' not found in " + configPath);
+}
+
+}
+
+std::string db::connectionInfo(const std::string &configPath, const std::string &clientName) {
+    const auto root = loadConfig(configPath);
+    const auto cfg = findClient(root, configPath, clientName);
+    std::ostringstream conn;
+    conn << "host=" << quoteConnValue(cfg.get("host", "127.0.0.1").asString())
+         << " port=" << cfg.get("port", 5432).asUInt()
+         << " dbname=" << quoteConnValue(cfg.get("dbname", "").asString())
+         << " user=" << quoteConnValue(cfg.get("user", "postgres").asString())
+         << " password=" << quoteConnValue(expandEnv(cfg.get("passwd", "").asString()));
+    // connect_options — параметры сессии, как у клиентов Drogon: {"search_path": "..."}
+    const auto &options = cfg["connect_options"];
+    if (options.isObject() && !options.empty()) {
+        std::string value;
+        for (const auto &key : options.getMemberNames()) {
+            value += (value.empty() ? "-c " : " -c ") + key + "=" + options[key].asString();
+        }
+        conn << " options=" << quoteConnValue(value);
+    }
+    return conn.str();
+}
+
+size_t db::connectionCount(const std::string &configPath, const std::string &clientName) {
+    const auto root = loadConfig(configPath);
+    const auto cfg = findClient(root, configPath, clientName);
+    size_t connections = std::max(1u, cfg.get("number_of_connections", 1).asUInt());
+    if (!cfg.get("is_fast", false).asBool()) {
+        return connections;
+    }
+    // У fast-клиента свои соединения в каждом IO-потоке; 0 потоков — по числу ядер
+    size_t threads = root["app"].get("number_of_threads", 1).asUInt();
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return connections * threads;
+}
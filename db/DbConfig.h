@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace db {
+
+// Строка подключения libpq для клиента clientName из секции db_clients
+// файла конфигурации. Пароль вида "$NAME" берётся из переменной окружения NAME,
+// connect_options передаются серверу как параметры сессии.
+// Бросает std::runtime_error, если файл не читается или клиента нет.
+std::string connectionInfo(const std::string &configPath,
+                           const std::string &clientName = "default");
+
+// Число соединений клиента clientName: number_of_connections, у fast-клиента
+// умноженное на число IO-потоков. Ошибки — как у connectionInfo.
+size_t connectionCount(const std::string &configPath,
+                       const std::string &clientName = "default");
+
+}
@@ -0,0 +1,86 @@
+#include "Deadline.h"
+#include <drogon/drogon.h>
+#include <drogon/orm/Exception.h>
+#include <chrono>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::string kDeadlineAttribute = "deadline";
+
+struct DeadlineConfig {
+    // 0 — без срока
+    int64_t defaultMs = 0;
+    // Ключ — "METHOD /шаблон" или "/шаблон" маршрута
+    std::unordered_map<std::string, int64_t> routes;
+    std::set<std::string, std::less<>> boundedStatements;
+};
+
+DeadlineConfig gConfig;
+
+int64_t routeBudgetMs(const drogon::HttpRequestPtr &req) {
+    if (gConfig.routes.empty()) {
+        return gConfig.defaultMs;
+    }
+    std::string pattern = req->getMatchedPathPattern().empty()
+                              ? req->path()
+                              : std::string(req->getMatchedPathPattern());
+    auto it = gConfig.routes.find(std::string(req->methodString()) + " " + pattern);
+    if (it != gConfig.routes.end()) {
+        return it->second;
+    }
+    it = gConfig.routes.find(pattern);
+    if (it != gConfig.routes.end()) {
+        return it->second;
+    }
+    return gConfig.defaultMs;
+}
+
+}
+
+void db::deadline::init() {
+    const auto &cfg = drogon::app().getCustomConfig()["deadlines"];
+    if (!cfg.isObject()) {
+        return;
+    }
+    gConfig.defaultMs = cfg.get("default_ms", 0).asInt64();
+    const auto &routes = cfg["routes"];
+    for (const auto &route : routes.getMemberNames()) {
+        gConfig.routes[route] = routes[route].asInt64();
+    }
+    for (const auto &statement : cfg["bounded_statements"]) {
+        gConfig.boundedStatements.insert(statement.asString());
+    }
+    if (gConfig.defaultMs <= 0 && gConfig.routes.empty()) {
+        return;
+    }
+
+    drogon::app().registerPostRoutingAdvice([](const drogon::HttpRequestPtr &req) {
+        const int64_t budgetMs = routeBudgetMs(req);
+        if (budgetMs > 0) {
+            req->attributes()->insert(kDeadlineAttribute,
+                                      Clock::now() + std::chrono::milliseconds(budgetMs));
+        }
+    });
+}
+
+std::optional<int64_t> db::deadline::remainingMs(const drogon::HttpRequestPtr &req) {
+    if (!req || !req->attributes()->find(kDeadlineAttribute)) {
+        return std::nullopt;
+    }
+    const auto deadline = req->attributes()->get<Clock::time_point>(kDeadlineAttribute);
+    const auto left =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    if (left <= 0) {
+        throw drogon::orm::TimeoutError("Request deadline exceeded");
+    }
+    return left;
+}
+
+bool db::deadline::isBounded(std::string_view statement) {
+    return gConfig.boundedStatements.find(statement) != gConfig.boundedStatements.end();
+}
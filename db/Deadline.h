@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <drogon/HttpRequest.h>
+
+// Крайний срок обработки запроса. Задаётся при маршрутизации по
+// custom_config.deadlines (для маршрута или по умолчанию) и соблюдается
+// обёртками db::execCoro и db::inTransaction: запрос к БД после истечения
+// срока не отправляется, транзакции выполняются с statement_timeout, равным
+// оставшемуся времени, а ожидание тяжёлых запросов обрывается по сроку на
+// стороне клиента (сервер прервёт их по statement_timeout соединения).
+namespace db::deadline {
+
+// Регистрирует установку срока для каждого запроса. Вызывается до app().run().
+void init();
+
+// Оставшееся до срока время в миллисекундах (не меньше 1); std::nullopt,
+// если срок не задан. Бросает drogon::orm::TimeoutError, если срок истёк.
+std::optional<int64_t> remainingMs(const drogon::HttpRequestPtr &req);
+
+// Запрос из custom_config.deadlines.bounded_statements: его ожидание
+// ограничено оставшимся до срока временем
+bool isBounded(std::string_view statement);
+
+}
@@ -0,0 +1,378 @@
+#include "Migrations.h"
+#include <drogon/drogon.h>
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include "db/DbConfig.h"
+#include "db/Statements.h"
+
+using drogon::orm::DbClientPtr;
+
+namespace {
+
+// Ключ pg_advisory_lock для миграций (произвольная константа приложения)
+constexpr int64_t kMigrationLockKey = 0x66696e6d6967;  // "finmig"
+constexpr double kMigrationTimeoutSec = 600;
+
+std::vector<db::migrations::Migration> buildMigrations() {
+    return {
+        // Исходная схема: совпадает с моделями в models/ и создаётся только там,
+        // где её ещё нет (БД, заведённые вручную, проходят эту версию без изменений)
+        {1, "initial_schema", false, {
+            R"(
+            DO $$ BEGIN
+                IF NOT EXISTS (SELECT 1 FROM pg_type WHERE typname = 'account_type') THEN
+                    CREATE TYPE account_type AS ENUM ('cash', 'card', 'deposit');
+                END IF;
+                IF NOT EXISTS (SELECT 1 FROM pg_type WHERE typname = 'category_type') THEN
+                    CREATE TYPE category_type AS ENUM ('income', 'expense');
+                END IF;
+            END $$
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS users (
+                id              BIGSERIAL PRIMARY KEY,
+                name            TEXT NOT NULL,
+                email           TEXT NOT NULL UNIQUE,
+                hashed_password TEXT NOT NULL,
+                created_at      TIMESTAMP NOT NULL DEFAULT NOW()
+            )
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS families (
+                id         BIGSERIAL PRIMARY KEY,
+                name       TEXT NOT NULL,
+                id_owner   BIGINT NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+                created_at TIMESTAMP NOT NULL DEFAULT NOW()
+            )
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS family_members (
+                id        SERIAL PRIMARY KEY,
+                id_family BIGINT NOT NULL REFERENCES families(id) ON DELETE CASCADE,
+                id_user   BIGINT NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+                joined_at TIMESTAMP NOT NULL DEFAULT NOW()
+            )
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS family_invite (
+                id         SERIAL PRIMARY KEY,
+                id_family  INTEGER NOT NULL REFERENCES families(id) ON DELETE CASCADE,
+                inviter_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+                token      TEXT NOT NULL,
+                email      TEXT NOT NULL,
+                used_at    TIMESTAMP,
+                created_at TIMESTAMP NOT NULL DEFAULT NOW()
+            )
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS account (
+                id           SERIAL PRIMARY KEY,
+                id_user      INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+                account_type account_type NOT NULL,
+                account_name TEXT NOT NULL,
+                balance      NUMERIC(14, 2) NOT NULL DEFAULT 0,
+                created_at   TIMESTAMP NOT NULL DEFAULT NOW(),
+                is_family    BOOLEAN NOT NULL DEFAULT FALSE
+            )
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS category (
+                id        SERIAL PRIMARY KEY,
+                id_user   INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+                name      TEXT NOT NULL,
+                type      category_type NOT NULL,
+                is_family BOOLEAN NOT NULL DEFAULT FALSE
+            )
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS transactions (
+                id          SERIAL PRIMARY KEY,
+                id_user     INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+                id_account  INTEGER NOT NULL REFERENCES account(id) ON DELETE CASCADE,
+                id_category INTEGER REFERENCES category(id) ON DELETE SET NULL,
+                amount      NUMERIC(14, 2) NOT NULL,
+                type        category_type NOT NULL,
+                description TEXT,
+                created_at  TIMESTAMP NOT NULL DEFAULT NOW(),
+                is_family   BOOLEAN NOT NULL DEFAULT FALSE
+            )
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS transfer (
+                id           SERIAL PRIMARY KEY,
+                id_user      INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+                account_from INTEGER NOT NULL REFERENCES account(id) ON DELETE CASCADE,
+                account_to   INTEGER NOT NULL REFERENCES account(id) ON DELETE CASCADE,
+                amount       NUMERIC(14, 2) NOT NULL,
+                created_at   TIMESTAMP NOT NULL DEFAULT NOW(),
+                is_family    BOOLEAN NOT NULL DEFAULT FALSE
+            )
+            )",
+            R"(
+            CREATE TABLE IF NOT EXISTS budgets (
+                id           SERIAL PRIMARY KEY,
+                id_user      INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+                id_category  INTEGER NOT NULL REFERENCES category(id) ON DELETE CASCADE,
+                month        INTEGER NOT NULL CHECK (month BETWEEN 1 AND 12),
+                year         INTEGER NOT NULL,
+                limit_amount NUMERIC(14, 2) NOT NULL,
+                created_at   TIMESTAMP NOT NULL DEFAULT NOW(),
+                is_family    BOOLEAN NOT NULL DEFAULT FALSE
+            )
+            )",
+        }},
+
+        // Индексы под горячие запросы из db/Statements.cc. Строятся CONCURRENTLY
+        // вне транзакции: обычный CREATE INDEX держал бы SHARE-блокировку и
+        // останавливал записи в журнал операций на всё время построения
+        {2, "hot_query_indexes", true, {
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS transactions_user_family_created_idx
+                ON transactions (id_user, is_family, created_at DESC)
+            )",
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS transfer_user_family_created_idx
+                ON transfer (id_user, is_family, created_at DESC)
+            )",
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS account_user_family_created_idx
+                ON account (id_user, is_family, created_at DESC)
+            )",
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS family_members_user_idx
+                ON family_members (id_user)
+            )",
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS family_members_family_user_idx
+                ON family_members (id_family, id_user)
+            )",
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS family_invite_token_idx
+                ON family_invite (token)
+            )",
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS family_invite_pending_email_idx
+                ON family_invite (email, created_at DESC)
+                WHERE used_at IS NULL
+            )",
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS budgets_user_period_category_idx
+                ON budgets (id_user, year, month, id_category)
+            )",
+            R"(
+            CREATE INDEX CONCURRENTLY IF NOT EXISTS category_user_idx
+                ON category (id_user)
+            )",
+        }},
+    };
+}
+
+// Невалидные индексы текущей схемы: остаются после прерванного
+// CREATE INDEX CONCURRENTLY и не используются планировщиком
+std::vector<std::string> invalidIndexes(const DbClientPtr &client) {
+    auto rows = client->execSqlSync(R"(
+        SELECT c.relname AS index_name
+        FROM pg_index ix
+        JOIN pg_class c ON c.oid = ix.indexrelid
+        JOIN pg_namespace n ON n.oid = c.relnamespace
+        WHERE n.nspname = current_schema()
+          AND NOT ix.indisvalid
+    )");
+    std::vector<std::string> names;
+    for (const auto &row : rows) {
+        names.push_back(row["index_name"].as<std::string>());
+    }
+    return names;
+}
+
+// Шаги выполняются по одному вне транзакции. Остатки прошлой неудачной
+// попытки удаляются заранее, иначе IF NOT EXISTS пропустил бы их; после
+// построения все индексы должны быть валидны.
+void applyConcurrent(const DbClientPtr &client, const db::migrations::Migration &m) {
+    for (const auto &name : invalidIndexes(client)) {
+        LOG_WARN << "Dropping invalid index " << name << " before migration " << m.version;
+        client->execSqlSync("DROP INDEX CONCURRENTLY IF EXISTS \"" + name + "\"");
+    }
+    for (const auto &step : m.steps) {
+        client->execSqlSync(step);
+    }
+    auto invalid = invalidIndexes(client);
+    if (!invalid.empty()) {
+        throw std::runtime_error("Migration " + std::to_string(m.version) + " (" + m.name +
+                                 ") left invalid index " + invalid.front());
+    }
+    client->execSqlSync("INSERT INTO schema_migrations (version, name) VALUES ($1, $2)",
+                        m.version, m.name);
+}
+
+}
+
+const std::vector<db::migrations::Migration> &db::migrations::migrations() {
+    static const std::vector<Migration> all = buildMigrations();
+    return all;
+}
+
+const std::vector<db::migrations::RequiredIndex> &db::migrations::requiredIndexes() {
+    // Собираются из реестра запросов: индекс объявляется рядом с запросом,
+    // которому он нужен, и не расходится с ним при переименовании
+    static const std::vector<RequiredIndex> all = [] {
+        std::vector<RequiredIndex> result;
+        for (const auto &st : db::statements()) {
+            for (const auto &spec : st.indexes) {
+                const size_t open = spec.find('(');
+                if (open == std::string::npos || spec.back() != ')') {
+                    throw std::logic_error("Bad index spec '" + spec + "' in " + st.name);
+                }
+                std::string table = spec.substr(0, open);
+                std::string columns = spec.substr(open + 1, spec.size() - open - 2);
+                auto it = std::find_if(result.begin(), result.end(), [&](const RequiredIndex &r) {
+                    return r.table == table && r.columns == columns;
+                });
+                if (it == result.end()) {
+                    result.push_back({std::move(table), std::move(columns), {}});
+                    it = std::prev(result.end());
+                }
+                it->statements.push_back(st.name);
+            }
+        }
+        return result;
+    }();
+    return all;
+}
+
+DbClientPtr db::migrations::clientFromConfig(const std::string &configPath,
+                                             const std::string &clientName) {
+    // Одно соединение: advisory-блокировка и транзакции идут по нему же
+    auto client = drogon::orm::DbClient::newPgClient(connectionInfo(configPath, clientName), 1);
+    // Построение индексов на больших таблицах может идти минуты,
+    // но недоступная БД не должна подвешивать запуск навсегда
+    client->setTimeout(kMigrationTimeoutSec);
+    return client;
+}
+
+int db::migrations::migrate(const DbClientPtr &client) {
+    // statement_timeout из connect_options рассчитан на запросы API,
+    // а построение индексов может идти дольше
+    client->execSqlSync("SET statement_timeout = 0");
+    client->execSqlSync(R"(
+        CREATE TABLE IF NOT EXISTS schema_migrations (
+            version    INTEGER PRIMARY KEY,
+            name       TEXT NOT NULL,
+            applied_at TIMESTAMP NOT NULL DEFAULT NOW()
+        )
+    )");
+    client->execSqlSync("SELECT pg_advisory_lock($1)", kMigrationLockKey);
+
+    int current = 0;
+    try {
+        auto rows = client->execSqlSync(
+            "SELECT COALESCE(MAX(version), 0) AS version FROM schema_migrations");
+        current = rows[0]["version"].as<int>();
+
+        for (const auto &m : migrations()) {
+            if (m.version <= current) {
+                continue;
+            }
+            LOG_INFO << "Applying migration " << m.version << " (" << m.name << ")";
+            if (m.concurrent) {
+                applyConcurrent(client, m);
+                current = m.version;
+                continue;
+            }
+            auto trans = client->newTransaction();
+            try {
+                for (const auto &step : m.steps) {
+                    trans->execSqlSync(step);
+                }
+                trans->execSqlSync(
+                    "INSERT INTO schema_migrations (version, name) VALUES ($1, $2)",
+                    m.version, m.name);
+            } catch (...) {
+                trans->rollback();
+                throw;
+            }
+            // COMMIT выполняется при освобождении транзакции; без ожидания его
+            // результата неудавшаяся миграция считалась бы применённой
+            std::promise<bool> committed;
+            auto result = committed.get_future();
+            trans->setCommitCallback([&committed](bool ok) { committed.set_value(ok); });
+            trans.reset();
+            if (!result.get()) {
+                throw std::runtime_error("Migration " + std::to_string(m.version) + " (" + m.name +
+                                         ") failed to commit");
+            }
+            current = m.version;
+        }
+    } catch (...) {
+        client->execSqlSync("SELECT pg_advisory_unlock($1)", kMigrationLockKey);
+        throw;
+    }
+
+    client->execSqlSync("SELECT pg_advisory_unlock($1)", kMigrationLockKey);
+    return current;
+}
+
+std::vector<db::migrations::RequiredIndex> db::migrations::missingIndexes(const DbClientPtr &client) {
+    // Столбцы каждого валидного индекса текущей схемы в порядке ключа
+    auto rows = client->execSqlSync(R"(
+        SELECT t.relname AS table_name,
+               array_to_string(ARRAY(
+                   SELECT a.attname
+                   FROM unnest(ix.indkey::int2[]) WITH ORDINALITY AS k(attnum, ord)
+                   JOIN pg_attribute a ON a.attrelid = t.oid AND a.attnum = k.attnum
+                   ORDER BY k.ord
+               ), ',') AS columns
+        FROM pg_index ix
+        JOIN pg_class t ON t.oid = ix.indrelid
+        JOIN pg_namespace n ON n.oid = t.relnamespace
+        WHERE n.nspname = current_schema()
+          AND ix.indisvalid
+    )");
+
+    std::vector<RequiredIndex> missing;
+    for (const auto &req : requiredIndexes()) {
+        bool found = false;
+        for (const auto &row : rows) {
+            if (row["table_name"].as<std::string>() != req.table) {
+                continue;
+            }
+            // Подходит индекс, ведущие столбцы которого совпадают с требуемыми
+            auto columns = row["columns"].as<std::string>();
+            if (columns == req.columns ||
+                (columns.rfind(req.columns, 0) == 0 && columns[req.columns.size()] == ',')) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            missing.push_back(req);
+        }
+    }
+    return missing;
+}
+
+bool db::migrations::run(const std::string &configPath) {
+    try {
+        auto client = clientFromConfig(configPath);
+        int version = migrate(client);
+        LOG_INFO << "Database schema is at version " << version;
+
+        auto missing = missingIndexes(client);
+        for (const auto &index : missing) {
+            std::string statements;
+            for (const auto &name : index.statements) {
+                statements += statements.empty() ? name : ", " + name;
+            }
+            LOG_WARN << "Missing index on " << index.table << "(" << index.columns
+                     << ") used by: " << statements;
+        }
+        return true;
+    } catch (const drogon::orm::DrogonDbException &e) {
+        LOG_ERROR << "Migration failed: " << e.base().what();
+    } catch (const std::exception &e) {
+        LOG_ERROR << "Migration failed: " << e.what();
+    }
+    return false;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <drogon/orm/DbClient.h>
+
+namespace db::migrations {
+
+// Версионированная миграция схемы. Шаги выполняются в одной транзакции
+// вместе с записью версии в schema_migrations. Миграция concurrent (только
+// CREATE INDEX CONCURRENTLY) идёт вне транзакции, не блокируя записи в
+// таблицы; после неё проверяется, что все индексы валидны.
+struct Migration {
+    int version;
+    std::string name;
+    bool concurrent;
+    std::vector<std::string> steps;
+};
+
+// Индекс, на который рассчитывают зарегистрированные запросы (поле indexes
+// в db/Statements.cc). columns — ведущие столбцы индекса через запятую.
+struct RequiredIndex {
+    std::string table;
+    std::string columns;
+    std::vector<std::string> statements;
+};
+
+// Все миграции по возрастанию версии
+const std::vector<Migration> &migrations();
+
+// Индексы, без которых горячие запросы уходят в последовательное чтение
+const std::vector<RequiredIndex> &requiredIndexes();
+
+// Синхронный (не fast) клиент к БД из секции db_clients файла конфигурации.
+// Нужен до app().run(), когда клиенты Drogon ещё не созданы.
+drogon::orm::DbClientPtr clientFromConfig(const std::string &configPath,
+                                          const std::string &clientName = "default");
+
+// Применяет недостающие миграции под advisory-блокировкой, чтобы несколько
+// экземпляров не мигрировали одновременно. Дожидается COMMIT каждой миграции
+// и бросает исключение, если он не удался. Возвращает текущую версию схемы.
+int migrate(const drogon::orm::DbClientPtr &client);
+
+// Требуемые индексы, которых нет в БД (пустой список — всё на месте)
+std::vector<RequiredIndex> missingIndexes(const drogon::orm::DbClientPtr &client);
+
+// Мигрирует БД клиента default из configPath и проверяет индексы
+// (недостающие пишутся в лог предупреждением). Возвращает false при ошибке миграции.
+bool run(const std::string &configPath);
+
+}
@@ -0,0 +1,146 @@
+#include "QueryMetrics.h"
+#include <drogon/HttpAppFramework.h>
+#include <drogon/plugins/PromExporter.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Gauge.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using drogon::monitoring::Collector;
+using drogon::monitoring::Counter;
+using drogon::monitoring::Gauge;
+using drogon::monitoring::Histogram;
+
+namespace {
+
+// Границы корзин: от 0.5 мс до 5 с — укладывается весь диапазон от точечных
+// проверок членства до тяжёлых семейных выборок
+const std::vector<double> kLatencyBuckets{
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5};
+const std::vector<double> kRowBuckets{
+    0, 1, 5, 10, 50, 100, 500, 1000, 5000, 10000};
+
+const std::shared_ptr<Collector<Histogram>> &latencyCollector() {
+    static const auto collector = std::make_shared<Collector<Histogram>>(
+        "db_query_duration_seconds",
+        "Database query latency by statement name",
+        std::vector<std::string>{"statement"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Histogram>> &rowsCollector() {
+    static const auto collector = std::make_shared<Collector<Histogram>>(
+        "db_query_rows",
+        "Rows returned or affected by statement name",
+        std::vector<std::string>{"statement"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Counter>> &errorsCollector() {
+    static const auto collector = std::make_shared<Collector<Counter>>(
+        "db_query_errors_total",
+        "Failed database queries by statement name",
+        std::vector<std::string>{"statement"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Counter>> &txRetriesCollector() {
+    static const auto collector = std::make_shared<Collector<Counter>>(
+        "db_transaction_retries_total",
+        "Transaction retries after serialization conflicts",
+        std::vector<std::string>{"transaction", "reason"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Counter>> &txFailuresCollector() {
+    static const auto collector = std::make_shared<Collector<Counter>>(
+        "db_transaction_failures_total",
+        "Transactions that failed after all attempts or with a non-retryable error",
+        std::vector<std::string>{"transaction"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Gauge>> &poolInFlightCollector() {
+    static const auto collector = std::make_shared<Collector<Gauge>>(
+        "db_pool_in_flight",
+        "Admitted requests currently using the database pool",
+        std::vector<std::string>{"pool"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Gauge>> &poolQueueCollector() {
+    static const auto collector = std::make_shared<Collector<Gauge>>(
+        "db_pool_queue_depth",
+        "Admitted requests beyond the number of pool connections",
+        std::vector<std::string>{"pool"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Counter>> &shedCollector() {
+    static const auto collector = std::make_shared<Collector<Counter>>(
+        "http_requests_shed_total",
+        "Requests rejected with 503 by admission control",
+        std::vector<std::string>{"pool", "kind"});
+    return collector;
+}
+
+double toSeconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+}
+
+void db::metrics::registerCollectors() {
+    auto exporter = drogon::app().getPlugin<drogon::plugin::PromExporter>();
+    if (!exporter) {
+        LOG_WARN << "PromExporter plugin is not enabled, query metrics are not exported";
+        return;
+    }
+    exporter->registerCollector(latencyCollector());
+    exporter->registerCollector(rowsCollector());
+    exporter->registerCollector(errorsCollector());
+    exporter->registerCollector(txRetriesCollector());
+    exporter->registerCollector(txFailuresCollector());
+    exporter->registerCollector(poolInFlightCollector());
+    exporter->registerCollector(poolQueueCollector());
+    exporter->registerCollector(shedCollector());
+}
+
+void db::metrics::observeQuery(std::string_view statement,
+                               std::chrono::steady_clock::duration elapsed,
+                               const drogon::orm::Result &result) {
+    std::vector<std::string> labels{std::string(statement)};
+    latencyCollector()->metric(labels, kLatencyBuckets)->observe(toSeconds(elapsed));
+    // Для INSERT/UPDATE/DELETE строк в результате нет — считаем затронутые
+    double rows = result.empty() ? static_cast<double>(result.affectedRows())
+                                 : static_cast<double>(result.size());
+    rowsCollector()->metric(labels, kRowBuckets)->observe(rows);
+}
+
+void db::metrics::observeQueryError(std::string_view statement,
+                                    std::chrono::steady_clock::duration elapsed) {
+    std::vector<std::string> labels{std::string(statement)};
+    latencyCollector()->metric(labels, kLatencyBuckets)->observe(toSeconds(elapsed));
+    errorsCollector()->metric(labels)->increment();
+}
+
+void db::metrics::observeTransactionRetry(std::string_view name, std::string_view reason) {
+    txRetriesCollector()->metric({std::string(name), std::string(reason)})->increment();
+}
+
+void db::metrics::observeTransactionFailure(std::string_view name) {
+    txFailuresCollector()->metric({std::string(name)})->increment();
+}
+
+void db::metrics::observePool(std::string_view pool, int64_t inFlight, int64_t queued) {
+    std::vector<std::string> labels{std::string(pool)};
+    poolInFlightCollector()->metric(labels)->set(static_cast<double>(inFlight));
+    poolQueueCollector()->metric(labels)->set(static_cast<double>(queued));
+}
+
+void db::metrics::observeShed(std::string_view pool, std::string_view kind) {
+    shedCollector()->metric({std::string(pool), std::string(kind)})->increment();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <drogon/orm/Result.h>
+
+namespace db::metrics {
+
+// Регистрирует коллекторы запросов в плагине PromExporter (/metrics).
+// Вызывать после инициализации плагинов, например из registerBeginningAdvice.
+void registerCollectors();
+
+// Успешный запрос: длительность и число строк (или затронутых строк для DML)
+void observeQuery(std::string_view statement,
+                  std::chrono::steady_clock::duration elapsed,
+                  const drogon::orm::Result &result);
+
+// Запрос завершился исключением
+void observeQueryError(std::string_view statement,
+                       std::chrono::steady_clock::duration elapsed);
+
+// Транзакция name повторяется после конфликта сериализации (reason: serialization,
+// deadlock или commit)
+void observeTransactionRetry(std::string_view name, std::string_view reason);
+
+// Транзакция name не завершилась: попытки исчерпаны или ошибка не повторяемая
+void observeTransactionFailure(std::string_view name);
+
+// Текущая нагрузка пула pool: запросы в работе и сверх числа соединений
+void observePool(std::string_view pool, int64_t inFlight, int64_t queued);
+
+// Запрос отклонён контролем допуска (kind: read или write)
+void observeShed(std::string_view pool, std::string_view kind);
+
+}
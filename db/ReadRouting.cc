@@ -0,0 +1,117 @@
+#include "ReadRouting.h"
+#include <drogon/drogon.h>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "utils/JwtUtils.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ReadRoutingConfig {
+    std::string readClientName;
+    Clock::duration readYourWritesWindow{std::chrono::seconds(5)};
+};
+
+ReadRoutingConfig gConfig;
+
+// Время последнего изменения по пользователям, разбитое на шарды со своими
+// мьютексами. Очередь шарда упорядочена по времени записи, а окно у всех
+// одинаковое, поэтому устаревшие записи снимаются с её начала без обхода
+// всей таблицы.
+struct alignas(64) WriteShard {
+    std::mutex mutex;
+    std::unordered_map<int64_t, Clock::time_point> lastWrite;
+    std::deque<std::pair<Clock::time_point, int64_t>> order;
+};
+
+constexpr size_t kWriteShards = 16;
+std::array<WriteShard, kWriteShards> gWrites;
+
+WriteShard &shardOf(int64_t userId) {
+    return gWrites[static_cast<uint64_t>(userId) % kWriteShards];
+}
+
+// Вызывается под мьютексом шарда
+void evictExpired(WriteShard &shard, Clock::time_point now) {
+    while (!shard.order.empty() &&
+           now - shard.order.front().first >= gConfig.readYourWritesWindow) {
+        const auto [at, userId] = shard.order.front();
+        shard.order.pop_front();
+        auto it = shard.lastWrite.find(userId);
+        // Более поздняя запись пользователя лежит дальше в очереди
+        if (it != shard.lastWrite.end() && it->second == at) {
+            shard.lastWrite.erase(it);
+        }
+    }
+}
+
+bool wroteRecently(int64_t userId) {
+    auto &shard = shardOf(userId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.lastWrite.find(userId);
+    return it != shard.lastWrite.end() &&
+           Clock::now() - it->second < gConfig.readYourWritesWindow;
+}
+
+}
+
+void db::initReadRouting() {
+    const auto &custom = drogon::app().getCustomConfig();
+    const auto &cfg = custom["read_replica"];
+    if (cfg.isObject()) {
+        gConfig.readClientName = cfg.get("client", "").asString();
+        gConfig.readYourWritesWindow =
+            std::chrono::milliseconds(cfg.get("read_your_writes_ms", 5000).asInt64());
+    }
+    if (gConfig.readClientName.empty()) {
+        return;
+    }
+
+    LOG_INFO << "Read-only handlers use db client '" << gConfig.readClientName << "'";
+    drogon::app().registerPostHandlingAdvice(
+        [](const drogon::HttpRequestPtr &req, const drogon::HttpResponsePtr &resp) {
+            if (req->method() == drogon::Get || req->method() == drogon::Head ||
+                req->method() == drogon::Options) {
+                return;
+            }
+            if (resp->statusCode() >= drogon::k400BadRequest) {
+                return;
+            }
+            if (auto userId = jwt_utils::getUserIdFromRequest(req)) {
+                markWrite(*userId);
+            }
+        });
+}
+
+std::string db::readClientName(std::optional<int64_t> userId) {
+    if (gConfig.readClientName.empty()) {
+        return "default";
+    }
+    if (userId && wroteRecently(*userId)) {
+        return "default";
+    }
+    auto replica = drogon::app().getFastDbClient(gConfig.readClientName);
+    if (!replica || !replica->hasAvailableConnections()) {
+        return "default";
+    }
+    return gConfig.readClientName;
+}
+
+drogon::orm::DbClientPtr db::readClient(std::optional<int64_t> userId) {
+    return drogon::app().getFastDbClient(readClientName(userId));
+}
+
+void db::markWrite(int64_t userId) {
+    const auto now = Clock::now();
+    auto &shard = shardOf(userId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    evictExpired(shard, now);
+    shard.lastWrite[userId] = now;
+    shard.order.emplace_back(now, userId);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <drogon/orm/DbClient.h>
+
+namespace db {
+
+// Настраивает маршрутизацию чтений по custom_config.read_replica и
+// регистрирует отметку изменений после каждого успешного не-GET запроса.
+// Вызывается до app().run().
+void initReadRouting();
+
+// Клиент для чистого чтения: read-only реплика, если она настроена и доступна.
+// Пользователь, недавно изменявший данные, читает с основного сервера,
+// чтобы сразу увидеть собственные изменения (read-your-writes). Время
+// изменений хранится в памяти экземпляра: за балансировщиком без привязки
+// пользователя к экземпляру чтение на другом экземпляре может уйти на реплику
+// и не увидеть изменение, пока она не догонит основной сервер.
+drogon::orm::DbClientPtr readClient(std::optional<int64_t> userId);
+
+// Имя клиента из db_clients, который выберет readClient
+std::string readClientName(std::optional<int64_t> userId);
+
+// Отмечает изменение данных пользователем
+void markWrite(int64_t userId);
+
+}
@@ -0,0 +1,216 @@
+#include "SingleFlight.h"
+#include <drogon/drogon.h>
+#include <trantor/net/EventLoop.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "db/ReadRouting.h"
+#include "utils/JwtUtils.h"
+
+using drogon::orm::Result;
+
+namespace {
+
+// Версии областей данных. Значения берутся из общего счётчика и только
+// растут, поэтому после очистки таблиц ключ не совпадёт с прежним.
+constexpr size_t kMaxScopes = 100000;
+
+std::mutex gVersionsMutex;
+uint64_t gStamp = 0;
+// Добавляется ко всем ключам; растёт при переполнении таблиц
+uint64_t gEpoch = 0;
+std::unordered_map<std::string, uint64_t> gScopeVersions;
+// Область семьи пользователя, замеченная при чтении семейных данных
+std::unordered_map<int64_t, std::string> gUserFamily;
+// Писавшие пользователи, чья семья ещё неизвестна: версия их семьи
+// поднимается при первом семейном чтении, до построения ключа
+std::unordered_set<int64_t> gUnattributed;
+
+std::string userScope(int64_t userId) {
+    return "user:" + std::to_string(userId);
+}
+
+// Вызывается под gVersionsMutex
+void bumpLocked(const std::string &scope) {
+    if (gScopeVersions.size() >= kMaxScopes) {
+        gScopeVersions.clear();
+        gEpoch = ++gStamp;
+    }
+    gScopeVersions[scope] = ++gStamp;
+}
+
+// Запрос в полёте: результат и ожидающие его вызовы
+struct Flight {
+    using Waiter = std::function<void(const std::optional<Result> &, std::exception_ptr)>;
+
+    std::mutex mutex;
+    bool done = false;
+    std::optional<Result> result;
+    std::exception_ptr error;
+    std::vector<Waiter> waiters;
+
+    // Вызывает waiter сразу, если запрос уже завершён
+    void subscribe(Waiter waiter) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!done) {
+                waiters.push_back(std::move(waiter));
+                return;
+            }
+        }
+        waiter(result, error);
+    }
+
+    void complete(std::optional<Result> value, std::exception_ptr e) {
+        std::vector<Waiter> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            result = std::move(value);
+            error = e;
+            done = true;
+            pending.swap(waiters);
+        }
+        for (auto &waiter : pending) {
+            waiter(result, error);
+        }
+    }
+};
+
+std::mutex gFlightsMutex;
+std::unordered_map<std::string, std::shared_ptr<Flight>> gFlights;
+
+// Ожидание чужого запроса. Корутина возобновляется в своём event loop,
+// даже если ведущий запрос завершился в другом потоке.
+struct FlightAwaiter : drogon::CallbackAwaiter<Result> {
+    explicit FlightAwaiter(std::shared_ptr<Flight> flight) : flight_(std::move(flight)) {}
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        auto *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        flight_->subscribe([this, handle, loop](const std::optional<Result> &value,
+                                                std::exception_ptr e) {
+            if (e) {
+                setException(e);
+            } else {
+                setValue(*value);
+            }
+            if (loop && !loop->isInLoopThread()) {
+                loop->queueInLoop([handle]() { handle.resume(); });
+            } else {
+                handle.resume();
+            }
+        });
+    }
+
+  private:
+    std::shared_ptr<Flight> flight_;
+};
+
+}
+
+void db::initSingleFlight() {
+    drogon::app().registerPostHandlingAdvice(
+        [](const drogon::HttpRequestPtr &req, const drogon::HttpResponsePtr &resp) {
+            if (req->method() == drogon::Get || req->method() == drogon::Head ||
+                req->method() == drogon::Options) {
+                return;
+            }
+            if (resp->statusCode() >= drogon::k400BadRequest) {
+                return;
+            }
+            if (auto userId = jwt_utils::getUserIdFromRequest(req)) {
+                noteWrite(*userId);
+            }
+        });
+}
+
+void db::noteWrite(int64_t userId) {
+    std::lock_guard<std::mutex> lock(gVersionsMutex);
+    bumpLocked(userScope(userId));
+    auto it = gUserFamily.find(userId);
+    if (it != gUserFamily.end()) {
+        bumpLocked(it->second);
+    } else {
+        if (gUnattributed.size() >= kMaxScopes) {
+            gUnattributed.clear();
+            gEpoch = ++gStamp;
+        }
+        gUnattributed.insert(userId);
+    }
+}
+
+void db::noteFamilyChange(int64_t familyId, int64_t userId) {
+    std::lock_guard<std::mutex> lock(gVersionsMutex);
+    bumpLocked("family:" + std::to_string(familyId));
+    gUserFamily.erase(userId);
+}
+
+std::string db::flightKey(const drogon::HttpRequestPtr &req, std::string_view scope) {
+    const auto userId = jwt_utils::getUserIdFromRequest(req);
+    std::string key = req->getMatchedPathPattern().empty()
+                          ? req->path()
+                          : std::string(req->getMatchedPathPattern());
+    key += '|';
+    key += db::readClientName(userId);
+    key += '|';
+    key += scope;
+    key += '|';
+
+    std::lock_guard<std::mutex> lock(gVersionsMutex);
+    if (userId && scope.starts_with("family:")) {
+        if (gUserFamily.size() >= kMaxScopes) {
+            gUserFamily.clear();
+        }
+        gUserFamily[*userId] = std::string(scope);
+        if (gUnattributed.erase(*userId)) {
+            bumpLocked(std::string(scope));
+        }
+    }
+    auto it = gScopeVersions.find(std::string(scope));
+    key += std::to_string(gEpoch);
+    key += '.';
+    key += std::to_string(it == gScopeVersions.end() ? 0 : it->second);
+    return key;
+}
+
+drogon::Task<Result> db::singleFlight(std::string key,
+                                      std::function<drogon::Task<Result>()> query) {
+    std::shared_ptr<Flight> flight;
+    bool leader = false;
+    {
+        std::lock_guard<std::mutex> lock(gFlightsMutex);
+        auto &slot = gFlights[key];
+        if (!slot) {
+            slot = std::make_shared<Flight>();
+            leader = true;
+        }
+        flight = slot;
+    }
+
+    if (!leader) {
+        co_return co_await FlightAwaiter(flight);
+    }
+
+    std::optional<Result> value;
+    std::exception_ptr error;
+    try {
+        value.emplace(co_await query());
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    // Снимаем запрос с учёта до оповещения: новые вызовы пойдут в БД заново
+    {
+        std::lock_guard<std::mutex> lock(gFlightsMutex);
+        gFlights.erase(key);
+    }
+    flight->complete(value, error);
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    co_return std::move(*value);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <drogon/HttpRequest.h>
+#include <drogon/orm/Result.h>
+#include <drogon/utils/coroutine.h>
+
+namespace db {
+
+// Регистрирует смену версии данных после каждого успешного не-GET запроса.
+// Вызывается до app().run().
+void initSingleFlight();
+
+// Отмечает изменение данных пользователем: растут версии его личной области
+// и его семьи, чтобы чтение, начатое после записи, не получило результат
+// запроса, запущенного до неё. Чтения других семей продолжают объединяться.
+void noteWrite(int64_t userId);
+
+// Пользователь userId вступил в семью familyId или покинул её
+void noteFamilyChange(int64_t familyId, int64_t userId);
+
+// Ключ объединения: шаблон маршрута, пул, из которого читает пользователь
+// (db::readClientName), область данных ("family:42") и её версия. Семья
+// пользователя запоминается по области "family:<id>" для noteWrite.
+std::string flightKey(const drogon::HttpRequestPtr &req, std::string_view scope);
+
+// Первый вызов с данным ключом выполняет query, остальные одновременные
+// вызовы ждут и получают тот же результат (или то же исключение)
+drogon::Task<drogon::orm::Result> singleFlight(
+    std::string key,
+    std::function<drogon::Task<drogon::orm::Result>()> query);
+
+}
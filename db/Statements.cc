@@ -0,0 +1,354 @@
+#include "Statements.h"
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+struct RawStatement {
+    const char *name;
+    const char *sql;
+    // Индексы, без которых запрос уходит в последовательное чтение:
+    // "таблица(ведущие,столбцы)" через ';'
+    const char *indexes = nullptr;
+};
+
+// Реестр всех SQL-запросов контроллеров.
+// Drogon готовит (PREPARE) каждый параметризованный текст один раз на соединение
+// и кэширует его, поэтому стабильный текст из реестра разбирается и планируется
+// однократно для каждого соединения пула.
+const RawStatement kStatements[] = {
+    // --- семья и членство ---
+    {"family_id_by_user", R"(
+        SELECT id_family FROM family_members WHERE id_user = $1
+    )", "family_members(id_user)"},
+    {"family_membership_exists", R"(
+        SELECT 1 FROM family_members WHERE id_user = $1
+    )", "family_members(id_user)"},
+    {"family_member_check", R"(
+        SELECT 1 FROM family_members WHERE id_family = $1::int8 AND id_user = $2::int8
+    )", "family_members(id_family,id_user)"},
+    {"family_by_member", R"(
+        SELECT f.id, f.name, f.id_owner, f.created_at
+        FROM families f
+        JOIN family_members fm ON f.id = fm.id_family
+        WHERE fm.id_user = $1
+    )", "family_members(id_user)"},
+    {"family_members_list", R"(
+        SELECT fm.id_user, u.name, u.email, fm.joined_at, f.id_owner
+        FROM family_members fm
+        JOIN users u ON fm.id_user = u.id
+        JOIN families f ON fm.id_family = f.id
+        WHERE fm.id_family = $1
+        ORDER BY fm.joined_at
+    )", "family_members(id_family,id_user)"},
+    {"family_owner", R"(
+        SELECT id_owner FROM families WHERE id = $1
+    )"},
+    {"family_member_insert", R"(
+        INSERT into family_members(id_family, id_user) VALUES ($1, $2)
+    )"},
+    {"family_member_delete", R"(
+        DELETE FROM family_members WHERE id_family = $1 AND id_user = $2
+    )", "family_members(id_family,id_user)"},
+
+    // --- приглашения ---
+    {"invite_insert_v2", R"(
+        INSERT INTO family_invite (id_family, inviter_id, token, email, created_at)
+        VALUES ($1::int4, $2::int4, $3, $4, NOW())
+    )"},
+    {"invite_by_token", R"(
+        SELECT id_family, email, used_at FROM family_invite WHERE token = $1
+    )", "family_invite(token)"},
+    {"invite_mark_used", R"(
+        UPDATE family_invite SET used_at = NOW() WHERE token = $1
+    )", "family_invite(token)"},
+    {"pending_invites_by_email", R"(
+        SELECT fi.id, fi.id_family, fi.email, fi.created_at, fi.token,
+               f.name as family_name, u.name as inviter_name
+        FROM family_invite fi
+        JOIN families f ON fi.id_family = f.id
+        JOIN users u ON fi.inviter_id = u.id
+        WHERE fi.email = $1
+        AND fi.used_at IS NULL
+        ORDER BY fi.created_at DESC
+    )", "family_invite(email)"},
+
+    // --- межэкземплярная инвалидация кэшей ---
+    {"cache_notify", R"(
+        SELECT pg_notify($1, $2)
+    )"},
+
+    // --- пользователи ---
+    {"user_auth_by_email", R"(
+        SELECT id, hashed_password from users WHERE email = $1
+    )", "users(email)"},
+    {"user_email_by_id", R"(
+        SELECT email FROM users WHERE id = $1
+    )"},
+    // Пересчитанный хеш записывается, только если пароль не сменили за это время
+    {"user_password_rehash", R"(
+        UPDATE users SET hashed_password = $1 WHERE id = $2::int8 AND hashed_password = $3
+    )"},
+
+    // --- счета ---
+    {"family_accounts", R"(
+        SELECT a.id, a.id_user, a.account_type, a.account_name, a.balance, a.created_at, a.is_family
+        FROM account a
+        JOIN family_members fm ON fm.id_user = a.id_user
+        WHERE fm.id_family = $1 AND a.is_family = TRUE
+        ORDER BY a.created_at DESC
+    )", "account(id_user,is_family,created_at);family_members(id_family,id_user)"},
+    {"personal_accounts_v3_ordered", R"(
+        SELECT id, id_user, account_type, account_name, balance, created_at, is_family
+        FROM account
+        WHERE id_user = $1::int8
+          AND is_family = FALSE
+        ORDER BY created_at DESC
+    )", "account(id_user,is_family,created_at)"},
+    {"account_owner", R"(
+        SELECT id_user, is_family FROM account WHERE id = $1::int8
+    )"},
+    {"account_update_family_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )", "family_members(id_user)"},
+
+    // --- категории ---
+    {"category_by_id", R"(
+        SELECT id, id_user, name, type, is_family FROM category WHERE id = $1::int8
+    )"},
+    {"personal_categories", R"(
+        SELECT id, id_user, name, type, is_family
+        FROM category
+        WHERE id_user = $1::int8
+          AND is_family = FALSE
+    )", "category(id_user)"},
+    {"family_categories_v2", R"(
+        SELECT c.id, c.id_user, c.name, c.type, c.is_family
+        FROM category c
+        JOIN family_members fm ON fm.id_user = c.id_user
+        WHERE fm.id_family = $1
+        AND c.is_family = TRUE
+    )", "family_members(id_family,id_user);category(id_user)"},
+    {"category_update_family_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"category_delete_family_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+
+    // --- транзакции ---
+    {"family_transactions_v2", R"(
+        SELECT t.*
+        FROM transactions t
+        JOIN family_members fm ON fm.id_user = t.id_user
+        WHERE fm.id_family IN (
+            SELECT fm2.id_family FROM family_members fm2 WHERE fm2.id_user = $1
+        )
+        AND t.is_family = TRUE
+        ORDER BY t.created_at DESC
+    )", "transactions(id_user,is_family,created_at)"},
+    {"personal_transactions_v2", R"(
+        SELECT * FROM transactions
+        WHERE id_user = $1::int8
+          AND is_family = FALSE
+        ORDER BY created_at DESC
+    )", "transactions(id_user,is_family,created_at)"},
+    {"tx_family_access_v2", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"tx_update_family_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"tx_update_old_acc_family", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"tx_update_new_acc_family", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"tx_delete_family_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"tx_delete_acc_family", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+
+    // --- переводы ---
+    {"family_transfers_v2", R"(
+        SELECT t.*
+        FROM transfer t
+        JOIN family_members fm ON fm.id_user = t.id_user
+        WHERE fm.id_family IN (
+            SELECT fm2.id_family FROM family_members fm2 WHERE fm2.id_user = $1
+        )
+        AND t.is_family = TRUE
+        ORDER BY t.created_at DESC
+    )", "transfer(id_user,is_family,created_at)"},
+    {"personal_transfers_v2", R"(
+        SELECT * FROM transfer
+        WHERE id_user = $1::int8
+          AND is_family = FALSE
+        ORDER BY created_at DESC
+    )", "transfer(id_user,is_family,created_at)"},
+    {"transfer_family_from_v2", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"transfer_family_to_v2", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"transfer_update_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"transfer_update_acc_access", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"transfer_delete_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"transfer_delete_acc", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+
+    // --- бюджеты ---
+    {"family_budgets_v3_ordered", R"(
+        SELECT b.id, b.id_user, b.id_category, b.month, b.year, b.limit_amount, b.is_family, b.created_at
+        FROM budgets b
+        JOIN family_members fm ON fm.id_user = b.id_user
+        WHERE fm.id_family IN (
+            SELECT fm2.id_family FROM family_members fm2 WHERE fm2.id_user = $1
+        )
+        AND b.is_family = TRUE
+        ORDER BY b.year DESC, b.month DESC
+    )", "budgets(id_user,year,month,id_category)"},
+    {"personal_budgets_v2_ordered", R"(
+        SELECT id, id_user, id_category, month, year, limit_amount, is_family, created_at
+        FROM budgets
+        WHERE id_user = $1::int8
+          AND is_family = FALSE
+        ORDER BY year DESC, month DESC
+    )", "budgets(id_user,year,month,id_category)"},
+    {"budget_dup_family_v2", R"(
+        SELECT 1 FROM budgets b
+        JOIN family_members fm ON fm.id_user = b.id_user
+        WHERE fm.id_family = $1::int8
+          AND b.id_category = $2::int4
+          AND b.month = $3::int4
+          AND b.year = $4::int4
+          AND b.is_family = TRUE
+        LIMIT 1
+    )", "family_members(id_family,id_user)"},
+    {"budget_dup_personal_v2", R"(
+        SELECT 1 FROM budgets
+        WHERE id_user = $1::int8
+          AND id_category = $2::int4
+          AND month = $3::int4
+          AND year = $4::int4
+          AND is_family = FALSE
+        LIMIT 1
+    )", "budgets(id_user,year,month,id_category)"},
+    {"budget_update_family_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"budget_update_cat_family", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+    {"budget_dup_update_family_v1", R"(
+        SELECT 1 FROM budgets b
+        JOIN family_members fm1 ON fm1.id_user = b.id_user
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm2.id_user = $1::int8
+          AND b.id_category = $2::int4
+          AND b.month = $3::int4
+          AND b.year = $4::int4
+          AND b.is_family = TRUE
+          AND b.id <> $5::int4
+    )"},
+    {"budget_dup_update_personal_v1", R"(
+        SELECT 1 FROM budgets
+        WHERE id_user = $1::int8
+          AND id_category = $2::int4
+          AND month = $3::int4
+          AND year = $4::int4
+          AND is_family = FALSE
+          AND id <> $5::int4
+    )", "budgets(id_user,year,month,id_category)"},
+    {"budget_delete_family_scope", R"(
+        SELECT 1 FROM family_members fm1
+        JOIN family_members fm2 ON fm1.id_family = fm2.id_family
+        WHERE fm1.id_user = $1::int8 AND fm2.id_user = $2::int8
+    )"},
+};
+
+std::vector<db::Statement> buildStatements() {
+    std::vector<db::Statement> result;
+    result.reserve(std::size(kStatements));
+    for (const auto &raw : kStatements) {
+        db::Statement st;
+        st.name = raw.name;
+        st.sql = "/*" + st.name + "*/" + raw.sql;
+        for (std::string_view rest = raw.indexes ? raw.indexes : ""; !rest.empty();) {
+            const size_t end = rest.find(';');
+            st.indexes.emplace_back(rest.substr(0, end));
+            rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+        }
+        result.push_back(std::move(st));
+    }
+    return result;
+}
+
+}
+
+const std::vector<db::Statement> &db::statements() {
+    static const std::vector<Statement> all = buildStatements();
+    return all;
+}
+
+const std::string &db::sql(std::string_view name) {
+    // Ключи указывают на строки внутри statements(), которые живут до конца программы
+    static const std::unordered_map<std::string_view, const Statement *> index = [] {
+        std::unordered_map<std::string_view, const Statement *> m;
+        for (const auto &st : statements()) {
+            m.emplace(st.name, &st);
+        }
+        return m;
+    }();
+
+    auto it = index.find(name);
+    if (it == index.end()) {
+        throw std::out_of_range("Unknown SQL statement: " + std::string(name));
+    }
+    return it->second->sql;
+}
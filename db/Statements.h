@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace db {
+
+// Именованный SQL-запрос. Текст хранится вместе с тегом /*name*/,
+// чтобы запрос было видно в pg_stat_statements и логах Postgres.
+struct Statement {
+    std::string name;
+    std::string sql;
+    // Требуемые индексы: "таблица(ведущие,столбцы)" (см. db::migrations::requiredIndexes)
+    std::vector<std::string> indexes;
+};
+
+// Все зарегистрированные запросы приложения
+const std::vector<Statement> &statements();
+
+// SQL по имени запроса; для неизвестного имени бросает std::out_of_range
+const std::string &sql(std::string_view name);
+
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <drogon/HttpRequest.h>
+#include <drogon/orm/CoroMapper.h>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "plugins/RequestTracer.h"
+
+// Интервалы трассы запроса (plugins/RequestTracer.h) вокруг ожиданий БД.
+// Для запросов вне выборки всё сводится к поиску атрибута запроса.
+namespace db::tracing {
+
+using Kind = finance::RequestTrace::Kind;
+
+// Интервал от создания до finish() или уничтожения
+class Span {
+public:
+    Span(const drogon::HttpRequestPtr &req,
+         std::string_view name,
+         Kind kind = Kind::Query,
+         std::string_view operation = {})
+        : trace_(finance::RequestTracer::traceOf(req)) {
+        if (!trace_) {
+            return;
+        }
+        span_.name = name;
+        if (!operation.empty()) {
+            span_.name += '.';
+            span_.name += operation;
+        }
+        span_.kind = kind;
+        span_.start = finance::RequestTrace::Clock::now();
+    }
+
+    Span(Span &&other) noexcept
+        : trace_(std::exchange(other.trace_, nullptr)), span_(std::move(other.span_)) {}
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+    Span &operator=(Span &&) = delete;
+
+    ~Span() { finish(); }
+
+    void setRows(int64_t rows) {
+        if (trace_) {
+            span_.rows = rows;
+        }
+    }
+
+    void setError(std::string_view what) {
+        if (trace_) {
+            span_.error = what;
+        }
+    }
+
+    void finish() {
+        if (!trace_) {
+            return;
+        }
+        span_.end = finance::RequestTrace::Clock::now();
+        std::exchange(trace_, nullptr)->addSpan(std::move(span_));
+    }
+
+private:
+    finance::RequestTrace *trace_;
+    finance::RequestTrace::Span span_;
+};
+
+// Ожидание awaiter внутри интервала; интервал закрывается при возобновлении
+// корутины, исключение записывается как ошибка интервала
+template <typename Awaiter>
+class TracedAwaiter {
+public:
+    TracedAwaiter(Span span, Awaiter inner) : span_(std::move(span)), inner_(std::move(inner)) {}
+
+    bool await_ready() { return inner_.await_ready(); }
+
+    decltype(auto) await_suspend(std::coroutine_handle<> handle) {
+        return inner_.await_suspend(handle);
+    }
+
+    decltype(auto) await_resume() {
+        struct Finish {
+            Span &span;
+            ~Finish() { span.finish(); }
+        } finish{span_};
+        try {
+            return inner_.await_resume();
+        } catch (const std::exception &e) {
+            span_.setError(e.what());
+            throw;
+        }
+    }
+
+private:
+    Span span_;
+    Awaiter inner_;
+};
+
+}
+
+namespace db {
+
+// CoroMapper, вызовы которого попадают в трассу запроса req как интервалы
+// "<таблица>.<операция>"
+template <typename T>
+class Mapper : public drogon::orm::CoroMapper<T> {
+    using Base = drogon::orm::CoroMapper<T>;
+
+public:
+    Mapper(const drogon::orm::DbClientPtr &client, drogon::HttpRequestPtr req)
+        : Base(client), req_(std::move(req)) {}
+
+    template <typename... Args>
+    auto findByPrimaryKey(Args &&...args) {
+        return traced("findByPrimaryKey", Base::findByPrimaryKey(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    auto findOne(Args &&...args) {
+        return traced("findOne", Base::findOne(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    auto findBy(Args &&...args) {
+        return traced("findBy", Base::findBy(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    auto count(Args &&...args) {
+        return traced("count", Base::count(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    auto insert(Args &&...args) {
+        return traced("insert", Base::insert(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    auto update(Args &&...args) {
+        return traced("update", Base::update(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    auto deleteByPrimaryKey(Args &&...args) {
+        return traced("deleteByPrimaryKey",
+                      Base::deleteByPrimaryKey(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    auto deleteBy(Args &&...args) {
+        return traced("deleteBy", Base::deleteBy(std::forward<Args>(args)...));
+    }
+
+private:
+    template <typename Awaiter>
+    tracing::TracedAwaiter<Awaiter> traced(std::string_view operation, Awaiter inner) {
+        return {tracing::Span(req_, T::tableName, tracing::Kind::Query, operation),
+                std::move(inner)};
+    }
+
+    drogon::HttpRequestPtr req_;
+};
+
+}
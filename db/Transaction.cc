@@ -0,0 +1,53 @@
+#include "Transaction.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+const db::detail::RetryPolicy &db::detail::retryPolicy() {
+    static const RetryPolicy policy = [] {
+        RetryPolicy p;
+        const auto &cfg = drogon::app().getCustomConfig()["transactions"];
+        if (cfg.isObject()) {
+            p.maxAttempts = std::max(1, cfg.get("max_attempts", p.maxAttempts).asInt());
+            p.baseBackoffSec = cfg.get("base_backoff_ms", 5).asDouble() / 1000.0;
+            p.maxBackoffSec = cfg.get("max_backoff_ms", 200).asDouble() / 1000.0;
+        }
+        return p;
+    }();
+    return policy;
+}
+
+double db::detail::backoffSeconds(int attempt) {
+    const auto &policy = retryPolicy();
+    const double cap = std::min(policy.maxBackoffSec,
+                                policy.baseBackoffSec * std::pow(2.0, attempt));
+    thread_local std::mt19937 rng{std::random_device{}()};
+    std::uniform_real_distribution<double> dist(0.0, cap);
+    return dist(rng);
+}
+
+const char *db::detail::retryReason(const drogon::orm::SqlError &e) {
+    const auto &state = e.sqlState();
+    if (state == "40001") {
+        return "serialization";
+    }
+    if (state == "40P01") {
+        return "deadlock";
+    }
+    return nullptr;
+}
+
+const std::string &db::detail::isolationSql(Isolation level) {
+    static const std::string readCommitted = "SET TRANSACTION ISOLATION LEVEL READ COMMITTED";
+    static const std::string repeatableRead = "SET TRANSACTION ISOLATION LEVEL REPEATABLE READ";
+    static const std::string serializable = "SET TRANSACTION ISOLATION LEVEL SERIALIZABLE";
+    switch (level) {
+    case Isolation::ReadCommitted:
+        return readCommitted;
+    case Isolation::RepeatableRead:
+        return repeatableRead;
+    case Isolation::Serializable:
+    default:
+        return serializable;
+    }
+}
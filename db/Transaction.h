@@ -0,0 +1,123 @@
+#pragma once
+#include <drogon/drogon.h>
+#include <drogon/orm/DbClient.h>
+#include <drogon/orm/Exception.h>
+#include <trantor/net/EventLoop.h>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "db/Deadline.h"
+#include "db/QueryMetrics.h"
+#include "db/Tracing.h"
+
+namespace db {
+
+using TransactionPtr = std::shared_ptr<drogon::orm::Transaction>;
+
+enum class Isolation {
+    ReadCommitted,
+    RepeatableRead,
+    Serializable,
+};
+
+namespace detail {
+
+// Параметры повторов из custom_config.transactions
+struct RetryPolicy {
+    int maxAttempts = 5;
+    double baseBackoffSec = 0.005;
+    double maxBackoffSec = 0.2;
+};
+
+const RetryPolicy &retryPolicy();
+
+// Пауза перед попыткой attempt + 1: случайная в [0, min(max, base * 2^attempt)]
+double backoffSeconds(int attempt);
+
+// Причина повтора для повторяемой ошибки (serialization, deadlock), иначе nullptr
+const char *retryReason(const drogon::orm::SqlError &e);
+
+const std::string &isolationSql(Isolation level);
+
+}
+
+// Выполняет fn(trans) в транзакции с уровнем изоляции level и фиксирует её.
+// Конфликты сериализации и взаимоблокировки (40001, 40P01), в том числе при
+// COMMIT, повторяются целиком с паузой со случайным разбросом; COMMIT без
+// SQLSTATE (обрыв соединения) не повторяется. Число повторов
+// и неудач публикуется в /metrics с меткой name. fn должна быть безопасна для
+// повторного вызова: всё состояние попытки — внутри неё. Срок запроса req
+// (db/Deadline.h) ограничивает каждую попытку через statement_timeout.
+// В трассу запроса (db/Tracing.h) попадают ожидание соединения, COMMIT и
+// паузы между попытками.
+template <typename T, typename Fn>
+drogon::Task<T> inTransaction(drogon::HttpRequestPtr req, std::string name, Isolation level, Fn fn) {
+    const auto &policy = detail::retryPolicy();
+    auto client = drogon::app().getFastDbClient();
+
+    for (int attempt = 1;; ++attempt) {
+        const char *reason = nullptr;
+        std::optional<T> result;
+        const auto timeoutMs = deadline::remainingMs(req);
+        {
+            tracing::Span beginSpan(req, name, tracing::Kind::Query, "begin");
+            auto trans = co_await client->newTransactionCoro();
+            try {
+                co_await trans->execSqlCoro(detail::isolationSql(level));
+                if (timeoutMs) {
+                    co_await trans->execSqlCoro("SET LOCAL statement_timeout = " +
+                                                std::to_string(*timeoutMs));
+                }
+                beginSpan.finish();
+                result.emplace(co_await fn(trans));
+            } catch (const drogon::orm::SqlError &e) {
+                trans->rollback();
+                reason = detail::retryReason(e);
+                if (!reason || attempt >= policy.maxAttempts) {
+                    metrics::observeTransactionFailure(name);
+                    throw;
+                }
+            } catch (...) {
+                trans->rollback();
+                throw;
+            }
+
+            if (!reason) {
+                // Явный COMMIT: commit-callback Drogon сообщает только bool, а
+                // конфликт SSI чаще всего приходит именно при фиксации. Так
+                // 40001/40P01 приходят как SqlError и повторяются; ошибка без
+                // SQLSTATE (обрыв соединения) оставляет исход неизвестным и не
+                // повторяется. Завершающий COMMIT самого Drogon после этого —
+                // пустая команда.
+                tracing::Span commitSpan(req, name, tracing::Kind::Query, "commit");
+                try {
+                    co_await trans->execSqlCoro("COMMIT");
+                    commitSpan.finish();
+                    co_return std::move(*result);
+                } catch (const drogon::orm::SqlError &e) {
+                    commitSpan.setError(e.what());
+                    trans->rollback();
+                    reason = detail::retryReason(e);
+                    if (!reason || attempt >= policy.maxAttempts) {
+                        metrics::observeTransactionFailure(name);
+                        throw;
+                    }
+                } catch (const std::exception &e) {
+                    commitSpan.setError(e.what());
+                    metrics::observeTransactionFailure(name);
+                    throw;
+                }
+            }
+        }
+
+        metrics::observeTransactionRetry(name, reason);
+        tracing::Span backoffSpan(req, name, tracing::Kind::Internal, "backoff");
+        auto *loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        co_await drogon::sleepCoro(loop ? loop : drogon::app().getLoop(),
+                                   detail::backoffSeconds(attempt));
+    }
+}
+
+}
@@ -1,8 +1,11 @@
 #include <drogon/drogon.h>
 #include <filesystem>
 #include <cstdlib>
+#include <cstring>
+#include "db/Migrations.h"
+#include "utils/AppSetup.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     // Загружаем конфиг: приоритет у переменной окружения DROGON_CONFIG,
     // иначе дефолтный ../config.json (относительно build/).
     std::string configPath = "../config.json";
@@ -11,12 +14,51 @@ int main() {
             configPath = envCfg;
         }
     }
-    drogon::app().loadConfigFile(configPath);
+
+    // --migrate: только применить миграции схемы и проверить индексы.
+    // При custom_config.migrations.run_on_startup то же делается перед запуском.
+    // --no-rate-limits: без finance::RateLimiter и пауз login_throttle, для
+    // прогона financial_manager_load/replay/stress против локального сервера.
+    bool migrateOnly = false;
+    bool noRateLimits = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--migrate") == 0) {
+            migrateOnly = true;
+        } else if (std::strcmp(argv[i], "--no-rate-limits") == 0) {
+            noRateLimits = true;
+        }
+    }
+
+    if (noRateLimits) {
+        try {
+            drogon::app().loadConfigJson(finance::configWithoutRateLimits(configPath));
+        } catch (const std::exception &e) {
+            LOG_ERROR << e.what();
+            return 1;
+        }
+        LOG_WARN << "Rate limits and login throttling are disabled (--no-rate-limits)";
+    } else {
+        drogon::app().loadConfigFile(configPath);
+    }
+
+    const auto &migrationsCfg = drogon::app().getCustomConfig()["migrations"];
+    if (migrateOnly || migrationsCfg.get("run_on_startup", false).asBool()) {
+        if (!db::migrations::run(configPath)) {
+            return 1;
+        }
+        if (migrateOnly) {
+            return 0;
+        }
+    }
 
     // Если в конфиге уже есть listeners, эту строку можно не вызывать,
     // но она не мешает и переопределяет адрес/порт при необходимости.
     drogon::app().addListener("0.0.0.0", 9000);
 
+    if (!finance::setupApp(configPath)) {
+        return 1;
+    }
+
     drogon::app().run();
     return 0;
 }
@@ -0,0 +1,130 @@
+#include "RateLimiter.h"
+#include <drogon/drogon.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "utils/ClientIp.h"
+#include "utils/JwtUtils.h"
+
+using namespace finance;
+
+namespace {
+
+// Ключи по IP отделены от id пользователей старшим битом
+constexpr uint64_t kIpKeyBit = 1ull << 63;
+
+drogon::HttpResponsePtr tooManyRequests(double retryAfterSec) {
+    auto resp = drogon::HttpResponse::newHttpResponse();
+    resp->setStatusCode(drogon::k429TooManyRequests);
+    resp->addHeader("Retry-After",
+                    std::to_string(std::max<int64_t>(1, std::llround(std::ceil(retryAfterSec)))));
+    resp->setBody("Too many requests");
+    return resp;
+}
+
+}
+
+void RateLimiter::initAndStart(const Json::Value &config) {
+    if (!config.get("enabled", true).asBool()) {
+        LOG_WARN << "RateLimiter is disabled";
+        return;
+    }
+    limits_[Read].name = "read";
+    limits_[Write].name = "write";
+    limits_[Auth].name = "auth";
+    loadLimit(limits_[Read], config["read"], 20, 40);
+    loadLimit(limits_[Write], config["write"], 5, 10);
+    loadLimit(limits_[Auth], config["auth"], 0.2, 5);
+    maxKeysPerShard_ = std::max<size_t>(1, config.get("max_keys", 262144).asUInt64() / kShards);
+
+    if (config.isMember("auth_paths")) {
+        for (const auto &path : config["auth_paths"]) {
+            authPaths_.push_back(path.asString());
+        }
+    } else {
+        authPaths_ = {"/api/auth/login", "/api/auth/register"};
+    }
+
+    drogon::app().registerPostRoutingAdvice(
+        [this](const drogon::HttpRequestPtr &req,
+               drogon::AdviceCallback &&respond,
+               drogon::AdviceChainCallback &&next) {
+            const Class cls = classify(req);
+            auto &limit = limits_[cls];
+            if (limit.rate <= 0) {
+                next();
+                return;
+            }
+            const double wait = take(limit, keyOf(req, cls));
+            if (wait > 0) {
+                respond(tooManyRequests(wait));
+                return;
+            }
+            next();
+        });
+
+    LOG_INFO << "RateLimiter started: read=" << limits_[Read].rate
+             << "/s write=" << limits_[Write].rate
+             << "/s auth=" << limits_[Auth].rate << "/s";
+}
+
+void RateLimiter::loadLimit(Limit &limit, const Json::Value &config, double rate, double burst) {
+    limit.rate = config.get("rate", rate).asDouble();
+    limit.burst = std::max(1.0, config.get("burst", burst).asDouble());
+}
+
+RateLimiter::Class RateLimiter::classify(const drogon::HttpRequestPtr &req) const {
+    for (const auto &path : authPaths_) {
+        if (req->path() == path) {
+            return Auth;
+        }
+    }
+    if (req->method() == drogon::Get || req->method() == drogon::Head ||
+        req->method() == drogon::Options) {
+        return Read;
+    }
+    return Write;
+}
+
+uint64_t RateLimiter::keyOf(const drogon::HttpRequestPtr &req, Class cls) const {
+    if (cls != Auth) {
+        if (auto userId = jwt_utils::getUserIdFromRequest(req)) {
+            return static_cast<uint64_t>(*userId) & ~kIpKeyBit;
+        }
+    }
+    return std::hash<std::string>{}(security::clientIp(req)) | kIpKeyBit;
+}
+
+double RateLimiter::take(Limit &limit, uint64_t key) {
+    auto &shard = limit.shards[(key ^ (key >> 29)) % kShards];
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (shard.buckets.size() >= maxKeysPerShard_ && !shard.buckets.count(key)) {
+        // Удаляем корзины, успевшие наполниться: их владельцы давно не приходили
+        for (auto it = shard.buckets.begin(); it != shard.buckets.end();) {
+            const double idle = std::chrono::duration<double>(now - it->second.updated).count();
+            if (it->second.tokens + idle * limit.rate >= limit.burst) {
+                it = shard.buckets.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (shard.buckets.size() >= maxKeysPerShard_) {
+            shard.buckets.clear();
+        }
+    }
+
+    auto [it, inserted] = shard.buckets.try_emplace(key, Bucket{limit.burst, now});
+    auto &bucket = it->second;
+    if (!inserted) {
+        const double elapsed = std::chrono::duration<double>(now - bucket.updated).count();
+        bucket.tokens = std::min(limit.burst, bucket.tokens + elapsed * limit.rate);
+        bucket.updated = now;
+    }
+    if (bucket.tokens >= 1.0) {
+        bucket.tokens -= 1.0;
+        return 0;
+    }
+    return (1.0 - bucket.tokens) / limit.rate;
+}
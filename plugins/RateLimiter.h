@@ -0,0 +1,66 @@
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace finance {
+
+// Ограничение частоты запросов к API по алгоритму token bucket. Чтения и
+// изменения считаются по id пользователя из JWT (без токена — по IP клиента,
+// см. security::clientIp), маршруты входа и регистрации — по IP, у каждого
+// класса свой бюджет.
+// Корзины разбиты на шарды со своими мьютексами, поэтому потоки почти не
+// конкурируют. При исчерпании бюджета — 429 с Retry-After.
+// "enabled": false отключает ограничение целиком (локальные нагрузочные
+// прогоны, см. ключ --no-rate-limits в main.cc).
+class RateLimiter : public drogon::Plugin<RateLimiter> {
+public:
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override {}
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Bucket {
+        double tokens;
+        Clock::time_point updated;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Bucket> buckets;
+    };
+
+    static constexpr size_t kShards = 64;
+
+    // Бюджет класса запросов: rate токенов в секунду, не больше burst
+    struct Limit {
+        std::string name;
+        double rate = 0;
+        double burst = 0;
+        std::array<Shard, kShards> shards;
+    };
+
+    enum Class { Read, Write, Auth, ClassCount };
+
+    void loadLimit(Limit &limit, const Json::Value &config, double rate, double burst);
+    Class classify(const drogon::HttpRequestPtr &req) const;
+    uint64_t keyOf(const drogon::HttpRequestPtr &req, Class cls) const;
+
+    // 0, если запрос пропущен, иначе через сколько секунд появится токен
+    double take(Limit &limit, uint64_t key);
+
+    std::array<Limit, ClassCount> limits_;
+    std::vector<std::string> authPaths_;
+    size_t maxKeysPerShard_{4096};
+};
+
+}
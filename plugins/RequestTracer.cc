@@ -0,0 +1,337 @@
+#include "RequestTracer.h"
+#include <drogon/drogon.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <random>
+
+using namespace finance;
+
+namespace {
+
+const std::string kTraceAttribute = "request_trace";
+
+std::atomic<bool> gRunning{false};
+
+// Виды интервалов OTLP
+constexpr int kSpanInternal = 1;
+constexpr int kSpanServer = 2;
+constexpr int kSpanClient = 3;
+
+std::mt19937_64 &rng() {
+    thread_local std::mt19937_64 gen{std::random_device{}()};
+    return gen;
+}
+
+std::string randomHex(size_t bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(bytes * 2);
+    uint64_t bits = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        if (i % 8 == 0) {
+            bits = rng()();
+        }
+        out += digits[bits & 0xf];
+        out += digits[(bits >> 4) & 0xf];
+        bits >>= 8;
+    }
+    return out;
+}
+
+bool isHex(std::string_view s) {
+    return std::all_of(s.begin(), s.end(), [](char c) {
+        return std::isdigit(static_cast<unsigned char>(c)) || (c >= 'a' && c <= 'f');
+    });
+}
+
+// traceparent версии 00: 00-<trace-id>-<parent-id>-<flags>
+bool parseTraceparent(const std::string &header, std::string &traceId, std::string &parentId) {
+    if (header.size() != 55 || header.compare(0, 3, "00-") != 0 || header[35] != '-' ||
+        header[52] != '-') {
+        return false;
+    }
+    std::string_view view(header);
+    auto trace = view.substr(3, 32);
+    auto parent = view.substr(36, 16);
+    auto flags = view.substr(53, 2);
+    if (!isHex(trace) || !isHex(parent) || !isHex(flags) ||
+        trace == std::string(32, '0') || parent == std::string(16, '0')) {
+        return false;
+    }
+    // Только если вызывающая сторона сама записывает эту трассу
+    if ((std::stoi(std::string(flags), nullptr, 16) & 1) == 0) {
+        return false;
+    }
+    traceId = trace;
+    parentId = parent;
+    return true;
+}
+
+Json::Value attribute(const char *key, const std::string &value) {
+    Json::Value attr;
+    attr["key"] = key;
+    attr["value"]["stringValue"] = value;
+    return attr;
+}
+
+// В OTLP-JSON 64-битные целые передаются строками
+Json::Value intAttribute(const char *key, int64_t value) {
+    Json::Value attr;
+    attr["key"] = key;
+    attr["value"]["intValue"] = std::to_string(value);
+    return attr;
+}
+
+Json::Value doubleAttribute(const char *key, double value) {
+    Json::Value attr;
+    attr["key"] = key;
+    attr["value"]["doubleValue"] = value;
+    return attr;
+}
+
+Json::Value span(const std::string &traceId,
+                 const std::string &parentId,
+                 const std::string &name,
+                 int kind,
+                 int64_t startNs,
+                 int64_t endNs) {
+    Json::Value out;
+    out["traceId"] = traceId;
+    out["spanId"] = randomHex(8);
+    if (!parentId.empty()) {
+        out["parentSpanId"] = parentId;
+    }
+    out["name"] = name;
+    out["kind"] = kind;
+    out["startTimeUnixNano"] = std::to_string(startNs);
+    out["endTimeUnixNano"] = std::to_string(endNs);
+    out["attributes"] = Json::Value(Json::arrayValue);
+    return out;
+}
+
+void setError(Json::Value &span, const std::string &message) {
+    span["status"]["code"] = 2;
+    span["status"]["message"] = message;
+}
+
+const Json::StreamWriterBuilder &lineWriter() {
+    static const Json::StreamWriterBuilder builder = [] {
+        Json::StreamWriterBuilder b;
+        b["indentation"] = "";
+        return b;
+    }();
+    return builder;
+}
+
+}
+
+void RequestTrace::addSpan(Span span) {
+    std::lock_guard lock(mutex_);
+    if (spans_.size() >= maxSpans_) {
+        ++dropped_;
+        return;
+    }
+    spans_.push_back(std::move(span));
+}
+
+void RequestTracer::initAndStart(const Json::Value &config) {
+    sampleRate_ = std::clamp(config.get("sample_rate", 0.01).asDouble(), 0.0, 1.0);
+    minDurationNs_ = config.get("min_duration_ms", 0).asInt64() * 1000000;
+    maxSpans_ = std::max<size_t>(1, config.get("max_spans", 256).asUInt64());
+    honorTraceparent_ = config.get("honor_traceparent", true).asBool();
+    serviceName_ = config.get("service_name", "financial_manager").asString();
+
+    std::string logPath = config.get("log_path", "").asString();
+    if (logPath.empty()) {
+        logPath = drogon::app().getLogPath();
+    }
+    if (logPath.empty()) {
+        logPath = "./";
+    } else if (logPath.back() != '/') {
+        logPath += '/';
+    }
+    std::string fileName = config.get("log_file", "traces.jsonl").asString();
+    std::string extName;
+    auto dot = fileName.rfind('.');
+    if (dot != std::string::npos) {
+        extName = fileName.substr(dot);
+        fileName = fileName.substr(0, dot);
+    }
+    logger_.setFileName(fileName, extName, logPath);
+    auto sizeLimit = config.get("log_size_limit", 0).asUInt64();
+    if (sizeLimit > 0) {
+        logger_.setFileSizeLimit(sizeLimit);
+    }
+    logger_.startLogging();
+    gRunning = true;
+
+    drogon::app().registerPostRoutingAdvice([this](const drogon::HttpRequestPtr &req) {
+        if (!gRunning.load(std::memory_order_relaxed) || req->getMatchedPathPattern().empty()) {
+            return;
+        }
+        if (auto trace = begin(req)) {
+            req->attributes()->insert(kTraceAttribute, std::move(trace));
+        }
+    });
+
+    drogon::app().registerPreSendingAdvice(
+        [this](const drogon::HttpRequestPtr &req, const drogon::HttpResponsePtr &resp) {
+            if (!req->attributes()->find(kTraceAttribute)) {
+                return;
+            }
+            auto trace =
+                req->attributes()->get<std::shared_ptr<RequestTrace>>(kTraceAttribute);
+            req->attributes()->erase(kTraceAttribute);
+            if (gRunning.load(std::memory_order_relaxed)) {
+                finish(req, resp, *trace);
+            }
+        });
+
+    LOG_INFO << "RequestTracer started: sample_rate=" << sampleRate_
+             << " min_duration_ms=" << minDurationNs_ / 1000000;
+}
+
+void RequestTracer::shutdown() {
+    gRunning = false;
+    logger_.flush();
+}
+
+RequestTrace *RequestTracer::traceOf(const drogon::HttpRequestPtr &req) {
+    if (!req || !req->attributes()->find(kTraceAttribute)) {
+        return nullptr;
+    }
+    return req->attributes()->get<std::shared_ptr<RequestTrace>>(kTraceAttribute).get();
+}
+
+std::shared_ptr<RequestTrace> RequestTracer::begin(const drogon::HttpRequestPtr &req) {
+    std::string traceId;
+    std::string parentId;
+    bool sampled = honorTraceparent_ &&
+                   parseTraceparent(req->getHeader("traceparent"), traceId, parentId);
+    if (!sampled) {
+        if (sampleRate_ <= 0.0) {
+            return nullptr;
+        }
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        if (sampleRate_ < 1.0 && dist(rng()) >= sampleRate_) {
+            return nullptr;
+        }
+        traceId = randomHex(16);
+    }
+
+    auto trace = std::make_shared<RequestTrace>();
+    trace->maxSpans_ = maxSpans_;
+    trace->traceId_ = std::move(traceId);
+    trace->parentSpanId_ = std::move(parentId);
+    trace->anchor_ = RequestTrace::Clock::now();
+    trace->anchorUnixNs_ = trantor::Date::date().microSecondsSinceEpoch() * 1000;
+    return trace;
+}
+
+void RequestTracer::finish(const drogon::HttpRequestPtr &req,
+                           const drogon::HttpResponsePtr &resp,
+                           RequestTrace &trace) {
+    const auto unixNs = [&trace](RequestTrace::Clock::time_point t) {
+        return trace.anchorUnixNs_ +
+               std::chrono::duration_cast<std::chrono::nanoseconds>(t - trace.anchor_).count();
+    };
+    const int64_t startNs = req->creationDate().microSecondsSinceEpoch() * 1000;
+    const int64_t endNs = unixNs(RequestTrace::Clock::now());
+    if (endNs - startNs < minDurationNs_) {
+        return;
+    }
+
+    std::vector<RequestTrace::Span> spans;
+    size_t dropped;
+    {
+        std::lock_guard lock(trace.mutex_);
+        spans.swap(trace.spans_);
+        dropped = trace.dropped_;
+    }
+    std::sort(spans.begin(), spans.end(), [](const auto &a, const auto &b) {
+        return a.start < b.start;
+    });
+
+    const std::string method(req->methodString());
+    const std::string route(req->getMatchedPathPattern());
+    const int status = static_cast<int>(resp->statusCode());
+
+    auto root = span(trace.traceId_, trace.parentSpanId_, method + " " + route, kSpanServer,
+                     startNs, endNs);
+    const std::string rootId = root["spanId"].asString();
+    Json::Value children(Json::arrayValue);
+
+    // Промежутки между ожиданиями — время, когда корутина обработчика
+    // выполнялась; перекрывающиеся ожидания (параллельные co_await) сливаются
+    int64_t cursor = startNs;
+    int64_t suspendedNs = 0;
+    int64_t runningNs = 0;
+    const auto addRunning = [&](int64_t from, int64_t to) {
+        if (to <= from) {
+            return;
+        }
+        runningNs += to - from;
+        auto slice = span(trace.traceId_, rootId, "handler", kSpanInternal, from, to);
+        slice["attributes"].append(attribute("fm.phase", "running"));
+        children.append(std::move(slice));
+    };
+
+    for (const auto &s : spans) {
+        const int64_t from = std::max(unixNs(s.start), startNs);
+        const int64_t to = std::min(std::max(unixNs(s.end), from), endNs);
+        addRunning(cursor, from);
+        if (to > cursor) {
+            suspendedNs += to - std::max(cursor, from);
+            cursor = to;
+        }
+
+        const bool query = s.kind == RequestTrace::Kind::Query;
+        auto child = span(trace.traceId_, rootId, s.name, query ? kSpanClient : kSpanInternal,
+                          from, to);
+        auto &attrs = child["attributes"];
+        attrs.append(attribute("fm.phase", "suspended"));
+        if (query) {
+            attrs.append(attribute("db.system", "postgresql"));
+            attrs.append(attribute("db.operation.name", s.name));
+        }
+        if (s.rows >= 0) {
+            attrs.append(intAttribute("db.response.returned_rows", s.rows));
+        }
+        if (!s.error.empty()) {
+            setError(child, s.error);
+        }
+        children.append(std::move(child));
+    }
+    addRunning(cursor, endNs);
+
+    auto &attrs = root["attributes"];
+    attrs.append(attribute("http.request.method", method));
+    attrs.append(attribute("http.route", route));
+    attrs.append(attribute("url.path", req->path()));
+    attrs.append(intAttribute("http.response.status_code", status));
+    attrs.append(intAttribute("fm.awaits", static_cast<int64_t>(spans.size())));
+    attrs.append(doubleAttribute("fm.suspended_ms", static_cast<double>(suspendedNs) / 1e6));
+    attrs.append(doubleAttribute("fm.running_ms", static_cast<double>(runningNs) / 1e6));
+    if (dropped > 0) {
+        attrs.append(intAttribute("fm.dropped_spans", static_cast<int64_t>(dropped)));
+    }
+    if (status >= 500) {
+        setError(root, "HTTP " + std::to_string(status));
+    }
+
+    Json::Value out;
+    auto &resource = out["resourceSpans"][0];
+    resource["resource"]["attributes"].append(attribute("service.name", serviceName_));
+    auto &scope = resource["scopeSpans"][0];
+    scope["scope"]["name"] = "finance::RequestTracer";
+    auto &list = scope["spans"];
+    list.append(std::move(root));
+    for (auto &child : children) {
+        list.append(std::move(child));
+    }
+
+    std::string line = Json::writeString(lineWriter(), out);
+    line += '\n';
+    logger_.output(line.data(), line.size());
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/utils/AsyncFileLogger.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace finance {
+
+// Трасса одного запроса: интервалы, в которых обработчик ждал БД.
+// Интервалы добавляются из корутин обработчика (db/Tracing.h), а при
+// отправке ответа RequestTracer записывает трассу целиком.
+class RequestTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Kind { Query, Internal };
+
+    struct Span {
+        std::string name;
+        Kind kind = Kind::Query;
+        Clock::time_point start;
+        Clock::time_point end;
+        int64_t rows = -1;  // -1 — неизвестно
+        std::string error;
+    };
+
+    void addSpan(Span span);
+
+private:
+    friend class RequestTracer;
+
+    std::mutex mutex_;
+    std::vector<Span> spans_;
+    size_t maxSpans_ = 0;
+    size_t dropped_ = 0;
+    std::string traceId_;
+    std::string parentSpanId_;
+    // Соответствие steady_clock и времени Unix, снятое при маршрутизации
+    Clock::time_point anchor_;
+    int64_t anchorUnixNs_ = 0;
+};
+
+// Трассировка запросов в файл в формате OTLP-JSON (по строке
+// ExportTraceServiceRequest на запрос). В выборку попадает доля запросов
+// sample_rate и запросы с заголовком traceparent с флагом sampled. Для
+// каждого запроса пишутся интервал запроса, вложенные интервалы запросов к
+// БД и вызовов мапперов (время, на которое корутина была приостановлена) и
+// интервалы handler между ними, когда обработчик выполнялся.
+class RequestTracer : public drogon::Plugin<RequestTracer> {
+public:
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+    // Трасса запроса req; nullptr, если запрос не в выборке или плагин выключен
+    static RequestTrace *traceOf(const drogon::HttpRequestPtr &req);
+
+private:
+    std::shared_ptr<RequestTrace> begin(const drogon::HttpRequestPtr &req);
+    void finish(const drogon::HttpRequestPtr &req,
+                const drogon::HttpResponsePtr &resp,
+                RequestTrace &trace);
+
+    double sampleRate_{0.01};
+    int64_t minDurationNs_{0};
+    size_t maxSpans_{256};
+    bool honorTraceparent_{true};
+    std::string serviceName_{"financial_manager"};
+
+    trantor::AsyncFileLogger logger_;
+};
+
+}
@@ -0,0 +1,154 @@
+#include "SlowQueryLog.h"
+#include <drogon/drogon.h>
+#include <trantor/utils/Date.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <random>
+#include <sstream>
+#include "db/Statements.h"
+
+using namespace finance;
+
+namespace {
+
+std::atomic<SlowQueryLog *> gInstance{nullptr};
+
+bool isSelect(const std::string &sql) {
+    // Пропускаем тег /*name*/ и пробелы в начале текста
+    size_t pos = 0;
+    auto tagEnd = sql.find("*/");
+    if (sql.rfind("/*", 0) == 0 && tagEnd != std::string::npos) {
+        pos = tagEnd + 2;
+    }
+    while (pos < sql.size() && std::isspace(static_cast<unsigned char>(sql[pos]))) {
+        ++pos;
+    }
+    std::string head = sql.substr(pos, 6);
+    std::transform(head.begin(), head.end(), head.begin(), ::toupper);
+    return head == "SELECT";
+}
+
+}
+
+void SlowQueryLog::initAndStart(const Json::Value &config) {
+    threshold_ = std::chrono::milliseconds(config.get("threshold_ms", 200).asInt64());
+    explainSampleRate_ = std::clamp(config.get("explain_sample_rate", 0.1).asDouble(), 0.0, 1.0);
+    explainCooldown_ = std::chrono::seconds(config.get("explain_cooldown_sec", 60).asInt64());
+
+    std::string logPath = config.get("log_path", "").asString();
+    if (logPath.empty()) {
+        logPath = drogon::app().getLogPath();
+    }
+    if (logPath.empty()) {
+        logPath = "./";
+    } else if (logPath.back() != '/') {
+        logPath += '/';
+    }
+    std::string fileName = config.get("log_file", "slow_query.log").asString();
+    std::string extName;
+    auto dot = fileName.rfind('.');
+    if (dot != std::string::npos) {
+        extName = fileName.substr(dot);
+        fileName = fileName.substr(0, dot);
+    }
+    logger_.setFileName(fileName, extName, logPath);
+    auto sizeLimit = config.get("log_size_limit", 0).asUInt64();
+    if (sizeLimit > 0) {
+        logger_.setFileSizeLimit(sizeLimit);
+    }
+    logger_.startLogging();
+
+    gInstance = this;
+    LOG_INFO << "SlowQueryLog started: threshold=" << config.get("threshold_ms", 200).asInt64()
+             << "ms explain_sample_rate=" << explainSampleRate_;
+}
+
+void SlowQueryLog::shutdown() {
+    gInstance = nullptr;
+    logger_.flush();
+}
+
+SlowQueryLog *SlowQueryLog::instance() {
+    return gInstance.load(std::memory_order_acquire);
+}
+
+bool SlowQueryLog::shouldExplain(std::string_view statement) {
+    if (explainSampleRate_ <= 0.0) {
+        return false;
+    }
+    thread_local std::mt19937 rng{std::random_device{}()};
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    if (dist(rng) >= explainSampleRate_) {
+        return false;
+    }
+
+    // Не чаще одного плана на запрос за explainCooldown_
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(explainMutex_);
+    auto [it, inserted] = lastExplain_.try_emplace(std::string(statement), now);
+    if (!inserted) {
+        if (now - it->second < explainCooldown_) {
+            return false;
+        }
+        it->second = now;
+    }
+    return true;
+}
+
+std::string SlowQueryLog::explainSql(std::string_view statement, bool analyze) {
+    const auto &sql = db::sql(statement);
+    if (analyze && isSelect(sql)) {
+        return "EXPLAIN (ANALYZE, BUFFERS) " + sql;
+    }
+    return "EXPLAIN " + sql;
+}
+
+void SlowQueryLog::logSlowQuery(std::string_view statement,
+                                std::string_view route,
+                                std::chrono::steady_clock::duration elapsed,
+                                const std::vector<std::string> &params) {
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(1);
+    oss << trantor::Date::now().toFormattedString(true)
+        << " slow_query statement=" << statement
+        << " duration_ms=" << std::chrono::duration<double, std::milli>(elapsed).count()
+        << " route=\"" << route << "\" params=[";
+    for (size_t i = 0; i < params.size(); ++i) {
+        if (i > 0) {
+            oss << ", ";
+        }
+        oss << params[i];
+    }
+    oss << "]\n";
+    write(oss.str());
+}
+
+void SlowQueryLog::logExplain(std::string_view statement, const drogon::orm::Result &plan) {
+    std::string out = trantor::Date::now().toFormattedString(true);
+    out += " explain statement=";
+    out += statement;
+    out += '\n';
+    for (const auto &row : plan) {
+        out += "    ";
+        out += row["QUERY PLAN"].as<std::string>();
+        out += '\n';
+    }
+    write(out);
+}
+
+void SlowQueryLog::logExplainError(std::string_view statement,
+                                   const drogon::orm::DrogonDbException &e) {
+    std::string out = trantor::Date::now().toFormattedString(true);
+    out += " explain_failed statement=";
+    out += statement;
+    out += " error=";
+    out += e.base().what();
+    out += '\n';
+    write(out);
+}
+
+void SlowQueryLog::write(const std::string &line) {
+    logger_.output(line.data(), line.size());
+}
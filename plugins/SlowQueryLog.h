@@ -0,0 +1,57 @@
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/orm/Result.h>
+#include <drogon/orm/Exception.h>
+#include <trantor/utils/AsyncFileLogger.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace finance {
+
+// Журнал медленных запросов. Пишет в отдельный файл имя запроса, маршрут,
+// длительность и замаскированные параметры; для части медленных запросов
+// асинхронно добавляет туда же EXPLAIN (ANALYZE, BUFFERS).
+class SlowQueryLog : public drogon::Plugin<SlowQueryLog> {
+public:
+    void initAndStart(const Json::Value &config) override;
+    void shutdown() override;
+
+    // nullptr, если плагин не включён в config.json
+    static SlowQueryLog *instance();
+
+    bool isSlow(std::chrono::steady_clock::duration elapsed) const {
+        return elapsed >= threshold_;
+    }
+
+    // Решает, снимать ли план для этого запроса (сэмплирование + пауза на запрос)
+    bool shouldExplain(std::string_view statement);
+
+    // Текст EXPLAIN для зарегистрированного запроса. Для не-SELECT запросов
+    // и при analyze = false ANALYZE не используется: запрос не выполняется.
+    static std::string explainSql(std::string_view statement, bool analyze = true);
+
+    void logSlowQuery(std::string_view statement,
+                      std::string_view route,
+                      std::chrono::steady_clock::duration elapsed,
+                      const std::vector<std::string> &params);
+    void logExplain(std::string_view statement, const drogon::orm::Result &plan);
+    void logExplainError(std::string_view statement, const drogon::orm::DrogonDbException &e);
+
+private:
+    void write(const std::string &line);
+
+    std::chrono::steady_clock::duration threshold_{std::chrono::milliseconds(200)};
+    double explainSampleRate_{0.1};
+    std::chrono::steady_clock::duration explainCooldown_{std::chrono::seconds(60)};
+
+    trantor::AsyncFileLogger logger_;
+    std::mutex explainMutex_;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastExplain_;
+};
+
+}
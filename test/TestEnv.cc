@@ -0,0 +1,323 @@
+#include "TestEnv.h"
+#include <drogon/drogon.h>
+#include <drogon/utils/coroutine.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <unistd.h>
+#include "db/Migrations.h"
+#include "utils/AppSetup.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string gBaseConfig;
+std::string gConfigPath;
+std::string gSchema;
+std::string gRunId;
+uint16_t gPort = 19099;
+double gLatencyScale = 1.0;
+bool gEnforceLatency = false;
+test_env::Seed gSeed;
+drogon::HttpClientPtr gClient;
+
+// Конфиг для тестов: единственный клиент default, привязанный к схеме
+// через search_path, без реплики и listeners; бюджеты RateLimiter не
+// должны мешать тестам, отправляющим запросы с одного адреса
+Json::Value testConfig(Json::Value root) {
+    Json::Value client;
+    for (const auto &cfg : root["db_clients"]) {
+        if (cfg.get("name", "default").asString() == "default") {
+            client = cfg;
+        }
+    }
+    if (client.isNull()) {
+        throw std::runtime_error("db client 'default' not found in " + gBaseConfig);
+    }
+    client["connect_options"]["search_path"] = gSchema;
+    root["db_clients"] = Json::Value(Json::arrayValue);
+    root["db_clients"].append(client);
+    root.removeMember("listeners");
+
+    auto &custom = root["custom_config"];
+    custom.removeMember("read_replica");
+    custom["migrations"]["run_on_startup"] = false;
+    if (custom["cache_bus"].isObject()) {
+        custom["cache_bus"]["channel"] = gSchema;
+    }
+
+    for (auto &plugin : root["plugins"]) {
+        if (plugin["name"].asString() != "finance::RateLimiter") {
+            continue;
+        }
+        for (const char *cls : {"read", "write", "auth"}) {
+            plugin["config"][cls]["rate"] = 100000;
+            plugin["config"][cls]["burst"] = 100000;
+        }
+    }
+    return root;
+}
+
+Json::Value readJson(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open config " + path);
+    }
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    if (!Json::parseFromStream(builder, in, &root, &errs)) {
+        throw std::runtime_error("Cannot parse config " + path + ": " + errs);
+    }
+    return root;
+}
+
+// Запрос в IO-потоке: fast-клиент БД доступен только из своих потоков
+std::string currentSchema() {
+    std::promise<std::string> promise;
+    auto future = promise.get_future();
+    drogon::app().getIOLoop(0)->queueInLoop([&promise]() {
+        drogon::async_run([&promise]() -> drogon::Task<> {
+            try {
+                auto rows = co_await drogon::app().getFastDbClient()->execSqlCoro(
+                    "SELECT current_schema() AS schema");
+                promise.set_value(rows[0]["schema"].as<std::string>());
+            } catch (const std::exception &e) {
+                promise.set_value(std::string("error: ") + e.what());
+            }
+        });
+    });
+    return future.get();
+}
+
+int64_t idOf(const test_env::Response &r) {
+    return r.json.isObject() ? r.json["id"].asInt64() : 0;
+}
+
+bool created(const test_env::Response &r, const char *what) {
+    if (r.status == 201 || r.status == 200) {
+        return true;
+    }
+    LOG_ERROR << "Seeding " << what << " failed with status " << r.status << ": "
+              << (r.resp ? std::string(r.resp->body()) : "no response");
+    return false;
+}
+
+bool registerUser(test_env::SeedUser &user, const std::string &name) {
+    user.email = test_env::uniqueEmail(name);
+    user.password = "test-password-" + name;
+    Json::Value body;
+    body["name"] = name;
+    body["email"] = user.email;
+    body["password"] = user.password;
+    auto r = test_env::call(drogon::Post, "/api/auth/register", &body);
+    if (!created(r, "user")) {
+        return false;
+    }
+    user.id = idOf(r);
+    user.token = r.json["token"].asString();
+    return true;
+}
+
+int64_t createAccount(const std::string &token, const char *name, const char *type,
+                      const char *balance, bool family) {
+    Json::Value body;
+    body["account_name"] = name;
+    body["account_type"] = type;
+    body["balance"] = balance;
+    auto r = test_env::call(drogon::Post, "/accounts", &body, token, family);
+    return created(r, "account") ? idOf(r) : 0;
+}
+
+int64_t createCategory(const std::string &token, const char *name, const char *type, bool family) {
+    Json::Value body;
+    body["name"] = name;
+    body["type"] = type;
+    auto r = test_env::call(drogon::Post, "/categories", &body, token, family);
+    return created(r, "category") ? idOf(r) : 0;
+}
+
+}
+
+test_env::Status test_env::prepare() {
+    const char *base = std::getenv("FINANCIAL_MANAGER_TEST_CONFIG");
+    if (!base || !*base) {
+        return Status::Skipped;
+    }
+    gBaseConfig = base;
+    if (const char *port = std::getenv("FINANCIAL_MANAGER_TEST_PORT")) {
+        gPort = static_cast<uint16_t>(std::atoi(port));
+    }
+    if (const char *scale = std::getenv("FINANCIAL_MANAGER_TEST_LATENCY_SCALE")) {
+        gLatencyScale = std::max(0.1, std::atof(scale));
+    }
+    if (const char *enforce = std::getenv("FINANCIAL_MANAGER_TEST_ENFORCE_LATENCY")) {
+        gEnforceLatency = std::string(enforce) == "1";
+    }
+
+    gRunId = std::to_string(getpid()) + "_" +
+             std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count());
+    gSchema = "fm_test_" + gRunId;
+
+    try {
+        auto admin = db::migrations::clientFromConfig(gBaseConfig);
+        admin->execSqlSync("CREATE SCHEMA " + gSchema);
+
+        gConfigPath = (std::filesystem::temp_directory_path() / (gSchema + ".json")).string();
+        std::ofstream out(gConfigPath);
+        out << testConfig(readJson(gBaseConfig)).toStyledString();
+    } catch (const std::exception &e) {
+        LOG_ERROR << "Test schema setup failed: " << e.what();
+        gSchema.clear();
+        return Status::Failed;
+    }
+
+    drogon::app().loadConfigFile(gConfigPath);
+    drogon::app().addListener("127.0.0.1", gPort);
+    if (!db::migrations::run(gConfigPath) || !finance::setupApp(gConfigPath)) {
+        return Status::Failed;
+    }
+    return Status::Ready;
+}
+
+bool test_env::seed() {
+    // Без connect_options клиент Drogon работал бы в схеме по умолчанию
+    const std::string schema = currentSchema();
+    if (schema != gSchema) {
+        LOG_ERROR << "App db client uses schema '" << schema << "' instead of '" << gSchema
+                  << "': db_clients.connect_options is not supported by this Drogon build";
+        return false;
+    }
+
+    auto &s = gSeed;
+    if (!registerUser(s.owner, "owner") || !registerUser(s.member, "member")) {
+        return false;
+    }
+
+    Json::Value family;
+    family["name"] = "Test family";
+    auto r = call(drogon::Post, "/api/family", &family, s.owner.token);
+    if (!created(r, "family")) {
+        return false;
+    }
+    s.familyId = idOf(r);
+
+    Json::Value invite;
+    invite["email"] = s.member.email;
+    r = call(drogon::Post, "/api/family/" + std::to_string(s.familyId) + "/invite", &invite,
+             s.owner.token);
+    if (!created(r, "invite")) {
+        return false;
+    }
+    const std::string url = r.json["join_url"].asString();
+    Json::Value join;
+    join["token"] = url.substr(url.find("token=") + 6);
+    join["email"] = s.member.email;
+    join["password"] = s.member.password;
+    if (!created(call(drogon::Post, "/api/family/join", &join), "family member")) {
+        return false;
+    }
+
+    s.card = createAccount(s.owner.token, "Test card", "card", "1000.00", false);
+    s.cash = createAccount(s.owner.token, "Test cash", "cash", "500.00", false);
+    s.familyAccount = createAccount(s.owner.token, "Test family", "card", "2000.00", true);
+    s.expenseCategory = createCategory(s.owner.token, "Test groceries", "expense", false);
+    s.incomeCategory = createCategory(s.owner.token, "Test salary", "income", false);
+    s.familyCategory = createCategory(s.owner.token, "Test family groceries", "expense", true);
+    if (!s.card || !s.cash || !s.familyAccount || !s.expenseCategory || !s.incomeCategory ||
+        !s.familyCategory) {
+        return false;
+    }
+
+    Json::Value budget;
+    budget["id_category"] = static_cast<Json::Int64>(s.expenseCategory);
+    budget["month"] = 1;
+    budget["year"] = 2030;
+    budget["limit_amount"] = "300.00";
+    r = call(drogon::Post, "/budgets", &budget, s.owner.token);
+    if (!created(r, "budget")) {
+        return false;
+    }
+    s.budget = idOf(r);
+    return true;
+}
+
+void test_env::teardown() {
+    gClient.reset();
+    if (!gSchema.empty()) {
+        try {
+            auto admin = db::migrations::clientFromConfig(gBaseConfig);
+            admin->execSqlSync("DROP SCHEMA " + gSchema + " CASCADE");
+        } catch (const std::exception &e) {
+            LOG_ERROR << "Failed to drop test schema " << gSchema << ": " << e.what();
+        }
+    }
+    if (!gConfigPath.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(gConfigPath, ec);
+    }
+}
+
+const test_env::Seed &test_env::data() {
+    return gSeed;
+}
+
+test_env::Response test_env::call(drogon::HttpMethod method,
+                                  const std::string &path,
+                                  const Json::Value *body,
+                                  const std::string &token,
+                                  bool family) {
+    if (!gClient) {
+        gClient = drogon::HttpClient::newHttpClient("http://127.0.0.1:" + std::to_string(gPort));
+    }
+    auto req = body ? drogon::HttpRequest::newHttpJsonRequest(*body)
+                    : drogon::HttpRequest::newHttpRequest();
+    req->setMethod(method);
+    req->setPath(path);
+    if (family) {
+        req->setParameter("family", "true");
+    }
+    if (!token.empty()) {
+        req->addHeader("Authorization", "Bearer " + token);
+    }
+
+    Response out;
+    out.route = std::string(drogon::to_string_view(method)) + " " + path;
+    const auto start = Clock::now();
+    auto [result, resp] = gClient->sendRequest(req, 30);
+    out.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (result != drogon::ReqResult::Ok || !resp) {
+        return out;
+    }
+    out.resp = resp;
+    out.status = static_cast<int>(resp->statusCode());
+    if (auto json = resp->getJsonObject()) {
+        out.json = *json;
+    }
+    return out;
+}
+
+double test_env::budget(double ms) {
+    return ms * gLatencyScale;
+}
+
+bool test_env::withinBudget(const Response &response, double budgetMs) {
+    const double limit = budget(budgetMs);
+    if (response.ms <= limit) {
+        return true;
+    }
+    LOG_WARN << "Latency budget exceeded: " << response.route << " took " << response.ms
+             << " ms, budget " << limit << " ms";
+    return !gEnforceLatency;
+}
+
+std::string test_env::uniqueEmail(const std::string &prefix) {
+    static int counter = 0;
+    return prefix + "-" + gRunId + "-" + std::to_string(++counter) + "@example.com";
+}
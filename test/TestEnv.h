@@ -0,0 +1,98 @@
+#pragma once
+#include <drogon/HttpClient.h>
+#include <jsoncpp/json/json.h>
+#include <cstdint>
+#include <string>
+
+// Окружение интеграционных тестов. Приложение запускается в процессе теста
+// с конфигом из FINANCIAL_MANAGER_TEST_CONFIG, но в одноразовой схеме
+// Postgres: схема создаётся перед стартом, в неё применяются миграции,
+// через API заводятся тестовые данные, после тестов схема удаляется.
+//
+// Переменные окружения:
+//   FINANCIAL_MANAGER_TEST_CONFIG        — конфиг с доступом к локальному Postgres
+//                                          (без неё тесты пропускаются)
+//   FINANCIAL_MANAGER_TEST_PORT          — порт приложения, по умолчанию 19099
+//   FINANCIAL_MANAGER_TEST_LATENCY_SCALE — множитель бюджетов задержки
+//                                          (например, 5 под sanitizers)
+//   FINANCIAL_MANAGER_TEST_ENFORCE_LATENCY — 1: превышение бюджета задержки
+//                                          проваливает тест; по умолчанию
+//                                          превышения только выводятся в лог
+namespace test_env {
+
+enum class Status { Ready, Skipped, Failed };
+
+struct SeedUser {
+    int64_t id = 0;
+    std::string email;
+    std::string password;
+    std::string token;
+};
+
+// Данные, заведённые до запуска тестов. Тесты их только читают, а свои
+// изменения делают на собственных строках.
+struct Seed {
+    SeedUser owner;   // владелец семьи
+    SeedUser member;  // член семьи
+    int64_t familyId = 0;
+    int64_t card = 0;           // личный счёт владельца, 1000.00
+    int64_t cash = 0;           // личный счёт владельца, 500.00
+    int64_t familyAccount = 0;  // семейный счёт владельца, 2000.00
+    int64_t expenseCategory = 0;
+    int64_t incomeCategory = 0;
+    int64_t familyCategory = 0;  // семейная категория расходов
+    int64_t budget = 0;
+};
+
+// Бюджеты задержки маршрутов, мс (до умножения на масштаб)
+constexpr double kReadMs = 150;
+constexpr double kWriteMs = 300;
+constexpr double kAuthMs = 1000;  // включает хеширование пароля
+constexpr double kPageMs = 150;
+
+struct Response {
+    std::string route;  // "METHOD путь" для отчёта о задержках
+    drogon::HttpResponsePtr resp;
+    int status = 0;  // 0 — сетевая ошибка
+    double ms = 0;
+    Json::Value json;
+};
+
+// До app().run(): схема, конфиг, миграции, настройка приложения
+Status prepare();
+
+// После старта event loop: проверка схемы и тестовые данные
+bool seed();
+
+// После app().quit(): удаление схемы и временного конфига
+void teardown();
+
+const Seed &data();
+
+// Синхронный запрос к запущенному приложению; family добавляет ?family=true
+Response call(drogon::HttpMethod method,
+              const std::string &path,
+              const Json::Value *body = nullptr,
+              const std::string &token = "",
+              bool family = false);
+
+// Бюджет с учётом FINANCIAL_MANAGER_TEST_LATENCY_SCALE
+double budget(double ms);
+
+// Задержка ответа в пределах бюджета. Без FINANCIAL_MANAGER_TEST_ENFORCE_LATENCY
+// всегда true, а превышение только выводится в лог: на загруженной машине
+// время не должно проваливать функциональные проверки.
+bool withinBudget(const Response &response, double budgetMs);
+
+// Уникальный email для пользователей, создаваемых тестами
+std::string uniqueEmail(const std::string &prefix);
+
+}
+
+// Статус ответа; задержка сверх бюджета выводится в лог и проваливает
+// тест только при FINANCIAL_MANAGER_TEST_ENFORCE_LATENCY=1
+#define CHECK_ROUTE(response, expectedStatus, budgetMs)          \
+    do {                                                         \
+        CHECK((response).status == (expectedStatus));            \
+        CHECK(test_env::withinBudget((response), (budgetMs)));   \
+    } while (0)
@@ -0,0 +1,367 @@
+// Интеграционные тесты маршрутов контроллеров: статус, содержимое ответа
+// и задержка в пределах бюджета (см. test/TestEnv.h)
+#include <drogon/drogon_test.h>
+#include <cmath>
+#include <stdexcept>
+#include "TestEnv.h"
+
+using drogon::Delete;
+using drogon::Get;
+using drogon::Post;
+using drogon::Put;
+using test_env::call;
+using test_env::data;
+using test_env::kAuthMs;
+using test_env::kPageMs;
+using test_env::kReadMs;
+using test_env::kWriteMs;
+
+namespace {
+
+// Строка массива ответа с заданным id
+const Json::Value *findById(const Json::Value &arr, int64_t id) {
+    for (const auto &row : arr) {
+        if (row["id"].asInt64() == id) {
+            return &row;
+        }
+    }
+    return nullptr;
+}
+
+// Баланс счёта владельца тестовых данных в копейках
+int64_t balanceOf(int64_t accountId) {
+    auto r = call(Get, "/accounts/" + std::to_string(accountId), nullptr, data().owner.token);
+    if (r.status != 200) {
+        throw std::runtime_error("GET /accounts/" + std::to_string(accountId) + " returned " +
+                                 std::to_string(r.status));
+    }
+    return std::llround(std::stod(r.json.get("balance", "0").asString()) * 100);
+}
+
+}
+
+DROGON_TEST(AuthRoutes)
+{
+    const std::string email = test_env::uniqueEmail("auth");
+    Json::Value reg;
+    reg["name"] = "Auth user";
+    reg["email"] = email;
+    reg["password"] = "auth-password";
+    auto r = call(Post, "/api/auth/register", &reg);
+    CHECK_ROUTE(r, 201, kAuthMs);
+
+    r = call(Post, "/api/auth/register", &reg);
+    CHECK(r.status == 409);
+
+    Json::Value login;
+    login["email"] = email;
+    login["password"] = "auth-password";
+    r = call(Post, "/api/auth/login", &login);
+    CHECK_ROUTE(r, 200, kAuthMs);
+    const std::string token = r.json["token"].asString();
+    REQUIRE(!token.empty());
+
+    login["password"] = "wrong-password";
+    r = call(Post, "/api/auth/login", &login);
+    CHECK(r.status == 401);
+
+    r = call(Get, "/api/auth/profile", nullptr, token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(r.json["email"].asString() == email);
+
+    r = call(Get, "/api/auth/profile");
+    CHECK(r.status == 401);
+
+    Json::Value profile;
+    profile["name"] = "Renamed";
+    r = call(Put, "/api/auth/profile", &profile, token);
+    CHECK_ROUTE(r, 200, kWriteMs);
+
+    r = call(Delete, "/api/auth/account", nullptr, token);
+    CHECK_ROUTE(r, 204, kWriteMs);
+}
+
+DROGON_TEST(AccountRoutes)
+{
+    const auto &s = data();
+    Json::Value account;
+    account["account_name"] = "Deposit";
+    account["account_type"] = "deposit";
+    account["balance"] = "42.50";
+    auto r = call(Post, "/accounts", &account, s.owner.token);
+    CHECK_ROUTE(r, 201, kWriteMs);
+    const int64_t id = r.json["id"].asInt64();
+    REQUIRE(id > 0);
+
+    r = call(Get, "/accounts", nullptr, s.owner.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(findById(r.json, id) != nullptr);
+    CHECK(findById(r.json, s.familyAccount) == nullptr);
+
+    r = call(Get, "/accounts", nullptr, s.member.token, true);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(findById(r.json, s.familyAccount) != nullptr);
+
+    r = call(Get, "/accounts/" + std::to_string(id), nullptr, s.owner.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(r.json["balance"].asString() == "42.50");
+
+    Json::Value update;
+    update["account_name"] = "Savings";
+    r = call(Put, "/accounts/" + std::to_string(id), &update, s.owner.token);
+    CHECK_ROUTE(r, 200, kWriteMs);
+
+    r = call(Put, "/accounts/" + std::to_string(id), &update, s.member.token);
+    CHECK(r.status >= 400);
+
+    r = call(Delete, "/accounts/" + std::to_string(id), nullptr, s.owner.token);
+    CHECK_ROUTE(r, 204, kWriteMs);
+
+    r = call(Get, "/accounts/" + std::to_string(id), nullptr, s.owner.token);
+    CHECK(r.status == 404);
+}
+
+DROGON_TEST(CategoryRoutes)
+{
+    const auto &s = data();
+    Json::Value category;
+    category["name"] = "Books";
+    category["type"] = "expense";
+    auto r = call(Post, "/categories", &category, s.owner.token);
+    CHECK_ROUTE(r, 201, kWriteMs);
+    const int64_t id = r.json["id"].asInt64();
+    REQUIRE(id > 0);
+
+    r = call(Get, "/categories", nullptr, s.owner.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(findById(r.json, id) != nullptr);
+
+    r = call(Get, "/categories", nullptr, s.member.token, true);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(findById(r.json, s.familyCategory) != nullptr);
+
+    Json::Value update;
+    update["name"] = "E-books";
+    r = call(Put, "/categories/" + std::to_string(id), &update, s.owner.token);
+    CHECK_ROUTE(r, 200, kWriteMs);
+    CHECK(r.json["name"].asString() == "E-books");
+
+    r = call(Delete, "/categories/" + std::to_string(id), nullptr, s.owner.token);
+    CHECK_ROUTE(r, 204, kWriteMs);
+}
+
+DROGON_TEST(TransactionRoutes)
+{
+    const auto &s = data();
+    const int64_t before = balanceOf(s.cash);
+
+    Json::Value tx;
+    tx["id_account"] = static_cast<Json::Int64>(s.cash);
+    tx["id_category"] = static_cast<Json::Int64>(s.expenseCategory);
+    tx["amount"] = "25.50";
+    tx["type"] = "expense";
+    tx["description"] = "Lunch";
+    auto r = call(Post, "/transactions", &tx, s.owner.token);
+    CHECK_ROUTE(r, 201, kWriteMs);
+    const int64_t id = r.json["id"].asInt64();
+    REQUIRE(id > 0);
+    CHECK(balanceOf(s.cash) == before - 2550);
+
+    // Категория дохода не подходит для расхода
+    tx["id_category"] = static_cast<Json::Int64>(s.incomeCategory);
+    r = call(Post, "/transactions", &tx, s.owner.token);
+    CHECK(r.status == 400);
+
+    // Чужой счёт
+    tx.removeMember("id_category");
+    r = call(Post, "/transactions", &tx, s.member.token);
+    CHECK(r.status == 403);
+
+    tx["amount"] = "1000000.00";
+    r = call(Post, "/transactions", &tx, s.owner.token);
+    CHECK(r.status == 400);
+
+    r = call(Get, "/transactions", nullptr, s.owner.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(findById(r.json, id) != nullptr);
+
+    r = call(Get, "/transactions/" + std::to_string(id), nullptr, s.owner.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(r.json["amount"].asString() == "25.50");
+
+    Json::Value update;
+    update["id_account"] = static_cast<Json::Int64>(s.cash);
+    update["amount"] = "20.00";
+    update["type"] = "expense";
+    r = call(Put, "/transactions/" + std::to_string(id), &update, s.owner.token);
+    CHECK_ROUTE(r, 200, kWriteMs);
+    CHECK(balanceOf(s.cash) == before - 2000);
+
+    r = call(Delete, "/transactions/" + std::to_string(id), nullptr, s.owner.token);
+    CHECK_ROUTE(r, 204, kWriteMs);
+    CHECK(balanceOf(s.cash) == before);
+
+    // Семейная транзакция члена семьи по счёту владельца
+    Json::Value family;
+    family["id_account"] = static_cast<Json::Int64>(s.familyAccount);
+    family["id_category"] = static_cast<Json::Int64>(s.familyCategory);
+    family["amount"] = "10.00";
+    family["type"] = "expense";
+    r = call(Post, "/transactions", &family, s.member.token, true);
+    CHECK_ROUTE(r, 201, kWriteMs);
+    const int64_t familyTx = r.json["id"].asInt64();
+
+    r = call(Get, "/transactions", nullptr, s.owner.token, true);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(findById(r.json, familyTx) != nullptr);
+
+    r = call(Delete, "/transactions/" + std::to_string(familyTx), nullptr, s.member.token, true);
+    CHECK_ROUTE(r, 204, kWriteMs);
+}
+
+DROGON_TEST(TransferRoutes)
+{
+    const auto &s = data();
+    const int64_t cardBefore = balanceOf(s.card);
+    const int64_t cashBefore = balanceOf(s.cash);
+
+    Json::Value transfer;
+    transfer["account_from"] = static_cast<Json::Int64>(s.card);
+    transfer["account_to"] = static_cast<Json::Int64>(s.cash);
+    transfer["amount"] = "100.00";
+    auto r = call(Post, "/transfers", &transfer, s.owner.token);
+    CHECK_ROUTE(r, 201, kWriteMs);
+    const int64_t id = r.json["id"].asInt64();
+    REQUIRE(id > 0);
+    CHECK(balanceOf(s.card) == cardBefore - 10000);
+    CHECK(balanceOf(s.cash) == cashBefore + 10000);
+
+    transfer["amount"] = "-5.00";
+    r = call(Post, "/transfers", &transfer, s.owner.token);
+    CHECK(r.status == 400);
+
+    transfer["amount"] = "100.00";
+    r = call(Post, "/transfers", &transfer, s.member.token);
+    CHECK(r.status == 403);
+
+    r = call(Get, "/transfers", nullptr, s.owner.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(findById(r.json, id) != nullptr);
+
+    Json::Value update;
+    update["account_from"] = static_cast<Json::Int64>(s.card);
+    update["account_to"] = static_cast<Json::Int64>(s.cash);
+    update["amount"] = "60.00";
+    r = call(Put, "/transfers/" + std::to_string(id), &update, s.owner.token);
+    CHECK_ROUTE(r, 200, kWriteMs);
+    CHECK(balanceOf(s.card) == cardBefore - 6000);
+
+    r = call(Delete, "/transfers/" + std::to_string(id), nullptr, s.owner.token);
+    CHECK_ROUTE(r, 204, kWriteMs);
+    CHECK(balanceOf(s.card) == cardBefore);
+    CHECK(balanceOf(s.cash) == cashBefore);
+}
+
+DROGON_TEST(BudgetRoutes)
+{
+    const auto &s = data();
+    Json::Value budget;
+    budget["id_category"] = static_cast<Json::Int64>(s.expenseCategory);
+    budget["month"] = 2;
+    budget["year"] = 2030;
+    budget["limit_amount"] = "150.00";
+    auto r = call(Post, "/budgets", &budget, s.owner.token);
+    CHECK_ROUTE(r, 201, kWriteMs);
+    const int64_t id = r.json["id"].asInt64();
+    REQUIRE(id > 0);
+
+    r = call(Get, "/budgets", nullptr, s.owner.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(findById(r.json, id) != nullptr);
+    CHECK(findById(r.json, s.budget) != nullptr);
+
+    Json::Value update;
+    update["limit_amount"] = "175.00";
+    r = call(Put, "/budgets/" + std::to_string(id), &update, s.owner.token);
+    CHECK_ROUTE(r, 200, kWriteMs);
+    CHECK(r.json["limit_amount"].asString() == "175.00");
+
+    r = call(Put, "/budgets/" + std::to_string(id), &update, s.member.token);
+    CHECK(r.status >= 400);
+
+    r = call(Delete, "/budgets/" + std::to_string(id), nullptr, s.owner.token);
+    CHECK_ROUTE(r, 204, kWriteMs);
+}
+
+DROGON_TEST(FamilyRoutes)
+{
+    const auto &s = data();
+    const std::string familyPath = "/api/family/" + std::to_string(s.familyId);
+
+    auto r = call(Get, "/api/family", nullptr, s.member.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+    CHECK(r.json["id"].asInt64() == s.familyId);
+    CHECK(r.json["is_owner"].asBool() == false);
+
+    r = call(Get, familyPath + "/members", nullptr, s.owner.token);
+    CHECK_ROUTE(r, 200, kReadMs);
+
+    // Новый участник: приглашение, список приглашений, вступление, выход
+    const std::string email = test_env::uniqueEmail("joiner");
+    Json::Value reg;
+    reg["name"] = "Joiner";
+    reg["email"] = email;
+    reg["password"] = "joiner-password";
+    r = call(Post, "/api/auth/register", &reg);
+    REQUIRE(r.status == 201);
+    const std::string token = r.json["token"].asString();
+    const int64_t userId = r.json["id"].asInt64();
+
+    Json::Value invite;
+    invite["email"] = email;
+    r = call(Post, familyPath + "/invite", &invite, s.owner.token);
+    CHECK_ROUTE(r, 201, kWriteMs);
+    const std::string url = r.json["join_url"].asString();
+    REQUIRE(url.find("token=") != std::string::npos);
+
+    // Приглашать может только член семьи
+    r = call(Post, familyPath + "/invite", &invite, token);
+    CHECK(r.status == 403);
+
+    r = call(Get, "/api/family/invites", nullptr, token);
+    CHECK_ROUTE(r, 200, kReadMs);
+
+    Json::Value join;
+    join["token"] = url.substr(url.find("token=") + 6);
+    join["email"] = email;
+    join["password"] = "wrong-password";
+    r = call(Post, "/api/family/join", &join);
+    CHECK(r.status == 400);
+
+    join["password"] = "joiner-password";
+    r = call(Post, "/api/family/join", &join);
+    CHECK_ROUTE(r, 200, kAuthMs);
+
+    r = call(Delete, familyPath + "/leave", nullptr, token);
+    CHECK_ROUTE(r, 200, kWriteMs);
+
+    r = call(Delete, familyPath + "/leave", nullptr, s.owner.token);
+    CHECK(r.status == 400);
+
+    // Повторное вступление невозможно: приглашение уже использовано
+    r = call(Post, "/api/family/join", &join);
+    CHECK(r.status >= 400);
+
+    r = call(Delete, familyPath + "/members/" + std::to_string(userId), nullptr, s.member.token);
+    CHECK(r.status >= 400);
+}
+
+DROGON_TEST(PageRoutes)
+{
+    for (const char *path : {"/", "/home", "/ui/categories", "/ui/transactions", "/ui/transfers",
+                             "/ui/budgets", "/accounts/create", "/family/create", "/family/members",
+                             "/family/invite", "/auth/register", "/auth/login", "/auth/logout"}) {
+        auto r = call(Get, path);
+        CHECK_ROUTE(r, 200, kPageMs);
+    }
+}
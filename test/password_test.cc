@@ -0,0 +1,101 @@
+// Модульные тесты форматов хешей паролей (utils/PasswordUtils.h): разбор
+// $pbkdf2-sha256$ и $scrypt$, проверка старого формата "<соль>$<хеш>"
+// и признак необходимости пересчёта
+#include <drogon/drogon_test.h>
+#include <jsoncpp/json/json.h>
+#include "utils/PasswordUtils.h"
+
+namespace {
+
+const std::string kPassword = "correct horse";
+
+// Эталонные хеши kPassword с солью a1b2...8f90 (hashlib.pbkdf2_hmac / hashlib.scrypt)
+const std::string kLegacyHash =
+    "a1b2c3d4e5f60718293a4b5c6d7e8f90$"
+    "d12277c1a5a026519bb3e6916c8167352a8069517ae483a82bd52d86cf933c1c";
+const std::string kPbkdf2Hash =
+    "$pbkdf2-sha256$i=1000$a1b2c3d4e5f60718293a4b5c6d7e8f90$"
+    "e3d51c9a48ef008e530760890b497b5f4601d4ece28301da002f703c0f0b8431";
+const std::string kScryptHash =
+    "$scrypt$ln=10,r=8,p=1$a1b2c3d4e5f60718293a4b5c6d7e8f90$"
+    "29ba484bf5028a28d5b1d653c127cf36e37305381d059ca5e3a415d39be0948b";
+
+void usePbkdf2(int iterations) {
+    Json::Value config;
+    config["algorithm"] = "pbkdf2-sha256";
+    config["pbkdf2_iterations"] = iterations;
+    security::configurePasswordHash(config);
+}
+
+void useScrypt(int logN) {
+    Json::Value config;
+    config["algorithm"] = "scrypt";
+    config["scrypt_log_n"] = logN;
+    config["scrypt_r"] = 8;
+    config["scrypt_p"] = 1;
+    security::configurePasswordHash(config);
+}
+
+}
+
+DROGON_TEST(PasswordHashKnownFormats)
+{
+    CHECK(security::verifyPassword(kPassword, kPbkdf2Hash));
+    CHECK(security::verifyPassword(kPassword, kScryptHash));
+    CHECK(!security::verifyPassword("wrong", kPbkdf2Hash));
+    CHECK(!security::verifyPassword("wrong", kScryptHash));
+
+    // Изменённый параметр стоимости даёт другой ключ
+    auto tampered = kPbkdf2Hash;
+    tampered.replace(tampered.find("i=1000"), 6, "i=1001");
+    CHECK(!security::verifyPassword(kPassword, tampered));
+}
+
+DROGON_TEST(PasswordHashLegacyFormat)
+{
+    CHECK(security::verifyPassword(kPassword, kLegacyHash));
+    CHECK(!security::verifyPassword("wrong", kLegacyHash));
+    CHECK(security::needsRehash(kLegacyHash));
+}
+
+DROGON_TEST(PasswordHashMalformed)
+{
+    for (const std::string hash : {
+             std::string("nodollar"),
+             std::string("$pbkdf2-sha256$i=abc$a1b2$00"),
+             std::string("$pbkdf2-sha256$n=1000$a1b2$00"),
+             std::string("$pbkdf2-sha256$i=0$a1b2$00"),
+             std::string("$pbkdf2-sha256$i=1000$a1b2"),
+             std::string("$scrypt$ln=10,r=8$a1b2$00"),
+             std::string("$scrypt$ln=10,r=8,p=1,x=2$a1b2$00"),
+             std::string("$scrypt$ln=40,r=8,p=1$a1b2$00"),
+             std::string("$md5$x$a1b2$00"),
+         }) {
+        CHECK(!security::verifyPassword(kPassword, hash));
+        CHECK(security::needsRehash(hash));
+    }
+}
+
+DROGON_TEST(PasswordHashRoundTrip)
+{
+    usePbkdf2(1000);
+    const auto pbkdf2 = security::hashPassword(kPassword);
+    CHECK(pbkdf2.rfind("$pbkdf2-sha256$i=1000$", 0) == 0);
+    CHECK(security::verifyPassword(kPassword, pbkdf2));
+    CHECK(!security::needsRehash(pbkdf2));
+    CHECK(!security::needsRehash(kPbkdf2Hash));
+    CHECK(security::needsRehash(kScryptHash));
+
+    useScrypt(10);
+    const auto scrypt = security::hashPassword(kPassword);
+    CHECK(scrypt.rfind("$scrypt$ln=10,r=8,p=1$", 0) == 0);
+    CHECK(security::verifyPassword(kPassword, scrypt));
+    CHECK(!security::needsRehash(scrypt));
+    CHECK(security::needsRehash(pbkdf2));
+
+    // Другая стоимость того же алгоритма — тоже повод пересчитать
+    useScrypt(11);
+    CHECK(security::needsRehash(scrypt));
+
+    security::configurePasswordHash(Json::Value(Json::objectValue));
+}
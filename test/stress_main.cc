@@ -0,0 +1,513 @@
+// Стресс-тест инвариантов баланса. Члены одной семьи одновременно создают
+// и удаляют транзакции и переводы по небольшому набору семейных счетов
+// (createTransaction, CreateTransfer, DeleteTransaction, DeleteTransfer).
+// После прогона баланс каждого счёта должен равняться начальному плюс сумма
+// его строк в журнале: доходы минус расходы, входящие минус исходящие переводы.
+//
+// Работает против запущенного сервера: адрес берётся из --url или
+// переменной FINANCIAL_MANAGER_URL; без них тест пропускается (код 77).
+// Сервер запускается с ключом --no-rate-limits, иначе бюджет записи
+// finance::RateLimiter упрётся в 429 (такие ответы повторяются после
+// Retry-After и считаются отдельно).
+//
+// Печатает строку JSON с пропускной способностью, исходами операций и
+// приростом db_transaction_retries_total / db_transaction_failures_total
+// с /metrics. Код возврата 1 — инвариант нарушен или подготовка не удалась.
+#include "bench/BenchUtils.h"
+#include <trantor/net/EventLoopThreadPool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using drogon::HttpClientPtr;
+using drogon::HttpResponsePtr;
+using drogon::Task;
+using bench::Clock;
+using bench::isSuccess;
+using bench::jsonId;
+
+namespace {
+
+constexpr int kSkipped = 77;
+
+struct Options {
+    std::string url;
+    int members = 4;
+    int accounts = 3;
+    int64_t ops = 5000;
+    int threads = 4;
+    int lanes = 16;
+    std::string startBalance = "100000.00";
+    double timeoutSec = 30;
+};
+
+Options gOptions;
+
+enum class Op { Income, Expense, Transfer, DeleteTransaction, DeleteTransfer };
+constexpr int kOpCount = 5;
+const char *kOpNames[kOpCount] = {"income", "expense", "transfer", "delete_transaction",
+                                  "delete_transfer"};
+
+struct Outcome {
+    std::atomic<int64_t> ok{0};
+    std::atomic<int64_t> rejected{0};      // 4xx: нехватка средств, уже удалено и т.п.
+    std::atomic<int64_t> serverErrors{0};  // 5xx: в том числе исчерпанные повторы конфликтов
+    std::atomic<int64_t> networkErrors{0};
+};
+
+struct Member {
+    std::string email;
+    std::string password;
+    std::string token;
+};
+
+// Общее состояние прогона: id созданных строк, которые ещё можно удалить
+struct State {
+    std::vector<Member> members;
+    std::vector<int64_t> accounts;
+    std::mutex mutex;
+    std::vector<int64_t> transactions;
+    std::vector<int64_t> transfers;
+    std::atomic<int64_t> issued{0};
+    std::atomic<int64_t> throttled{0};
+    Outcome outcomes[kOpCount];
+};
+
+State gState;
+
+// Ответы 429/503 повторяются после Retry-After и считаются в throttled
+Task<HttpResponsePtr> send(HttpClientPtr client,
+                           trantor::EventLoop *loop,
+                           drogon::HttpMethod method,
+                           const std::string &path,
+                           const Json::Value *body,
+                           const std::string &token,
+                           bool family = false) {
+    return bench::send(std::move(client), loop, {method, family ? path + "?family=true" : path, body, token},
+                       gOptions.timeoutSec, bench::Retry{50, 0.05, 5.0},
+                       [](const HttpResponsePtr &resp, double) {
+                           if (bench::isThrottled(resp)) {
+                               ++gState.throttled;
+                           }
+                       });
+}
+
+// "-123.4" -> -12340; суммы в БД хранятся как NUMERIC(14,2)
+int64_t toCents(const std::string &amount) {
+    const bool negative = !amount.empty() && amount[0] == '-';
+    int64_t units = 0;
+    int64_t cents = 0;
+    int fraction = -1;
+    for (char c : amount) {
+        if (c == '.') {
+            fraction = 0;
+        } else if (c >= '0' && c <= '9') {
+            if (fraction < 0) {
+                units = units * 10 + (c - '0');
+            } else if (fraction < 2) {
+                cents = cents * 10 + (c - '0');
+                ++fraction;
+            }
+        }
+    }
+    if (fraction == 1) {
+        cents *= 10;
+    }
+    const int64_t total = units * 100 + cents;
+    return negative ? -total : total;
+}
+
+std::string formatCents(int64_t cents) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%s%lld.%02lld", cents < 0 ? "-" : "",
+                  static_cast<long long>(std::llabs(cents) / 100),
+                  static_cast<long long>(std::llabs(cents) % 100));
+    return buf;
+}
+
+// Регистрация и вход всех членов, семья владельца первого из них, семейные
+// счета с начальным балансом
+Task<bool> setup(HttpClientPtr client, trantor::EventLoop *loop) {
+    const std::string runId = bench::defaultRunId();
+    for (int i = 0; i < gOptions.members; ++i) {
+        Member m;
+        m.email = "stress-" + runId + "-" + std::to_string(i) + "@example.com";
+        m.password = "stress-password-" + std::to_string(i);
+
+        Json::Value reg;
+        reg["name"] = "Stress " + std::to_string(i);
+        reg["email"] = m.email;
+        reg["password"] = m.password;
+        co_await send(client, loop, drogon::Post, "/api/auth/register", &reg, "");
+
+        Json::Value login;
+        login["email"] = m.email;
+        login["password"] = m.password;
+        auto resp = co_await send(client, loop, drogon::Post, "/api/auth/login", &login, "");
+        if (!isSuccess(resp) || !resp->getJsonObject()) {
+            std::fprintf(stderr, "login failed for %s\n", m.email.c_str());
+            co_return false;
+        }
+        m.token = (*resp->getJsonObject())["token"].asString();
+        gState.members.push_back(std::move(m));
+    }
+
+    const auto &owner = gState.members.front();
+    Json::Value family;
+    family["name"] = "Stress family " + runId;
+    auto resp = co_await send(client, loop, drogon::Post, "/api/family", &family, owner.token);
+    if (!isSuccess(resp)) {
+        std::fprintf(stderr, "family creation failed\n");
+        co_return false;
+    }
+    const std::string familyId = std::to_string(jsonId(resp));
+
+    for (size_t i = 1; i < gState.members.size(); ++i) {
+        const auto &member = gState.members[i];
+        Json::Value invite;
+        invite["email"] = member.email;
+        resp = co_await send(client, loop, drogon::Post, "/api/family/" + familyId + "/invite",
+                             &invite, owner.token);
+        const std::string url = isSuccess(resp) && resp->getJsonObject()
+                                    ? (*resp->getJsonObject())["join_url"].asString()
+                                    : "";
+        const auto pos = url.find("token=");
+        if (pos == std::string::npos) {
+            std::fprintf(stderr, "invite failed for %s\n", member.email.c_str());
+            co_return false;
+        }
+        Json::Value join;
+        join["token"] = url.substr(pos + 6);
+        join["email"] = member.email;
+        join["password"] = member.password;
+        resp = co_await send(client, loop, drogon::Post, "/api/family/join", &join, "");
+        if (!isSuccess(resp)) {
+            std::fprintf(stderr, "join failed for %s\n", member.email.c_str());
+            co_return false;
+        }
+    }
+
+    for (int i = 0; i < gOptions.accounts; ++i) {
+        Json::Value account;
+        account["account_name"] = "Stress " + std::to_string(i);
+        account["account_type"] = "card";
+        account["balance"] = gOptions.startBalance;
+        resp = co_await send(client, loop, drogon::Post, "/accounts", &account, owner.token, true);
+        if (!isSuccess(resp)) {
+            std::fprintf(stderr, "account creation failed\n");
+            co_return false;
+        }
+        gState.accounts.push_back(jsonId(resp));
+    }
+    co_return true;
+}
+
+// Забирает случайный id из пула, чтобы две полосы не удаляли одну строку
+int64_t takeRandom(std::vector<int64_t> &pool, std::mt19937 &rng) {
+    std::lock_guard<std::mutex> lock(gState.mutex);
+    if (pool.empty()) {
+        return 0;
+    }
+    const size_t i = rng() % pool.size();
+    std::swap(pool[i], pool.back());
+    const int64_t id = pool.back();
+    pool.pop_back();
+    return id;
+}
+
+void record(Op op, const HttpResponsePtr &resp) {
+    auto &outcome = gState.outcomes[static_cast<int>(op)];
+    if (!resp) {
+        ++outcome.networkErrors;
+    } else if (static_cast<int>(resp->statusCode()) >= 500) {
+        ++outcome.serverErrors;
+    } else if (static_cast<int>(resp->statusCode()) >= 400) {
+        ++outcome.rejected;
+    } else {
+        ++outcome.ok;
+    }
+}
+
+// Полоса нагрузки: последовательные операции от имени одного члена семьи
+Task<> lane(int index, trantor::EventLoop *loop) {
+    auto client = drogon::HttpClient::newHttpClient(gOptions.url, loop);
+    const auto &member = gState.members[static_cast<size_t>(index) % gState.members.size()];
+    std::mt19937 rng(static_cast<unsigned>(index) * 7919U + 17U);
+    std::uniform_int_distribution<int64_t> cents(1, 50000);
+    const auto &accounts = gState.accounts;
+
+    while (gState.issued.fetch_add(1) < gOptions.ops) {
+        // Доли: 25% доходов, 20% расходов, 25% переводов, 30% удалений
+        const int pick = static_cast<int>(rng() % 100);
+        Op op = pick < 25 ? Op::Income
+              : pick < 45 ? Op::Expense
+              : pick < 70 ? Op::Transfer
+              : pick < 85 ? Op::DeleteTransaction
+                          : Op::DeleteTransfer;
+
+        HttpResponsePtr resp;
+        if (op == Op::DeleteTransaction || op == Op::DeleteTransfer) {
+            auto &pool = op == Op::DeleteTransaction ? gState.transactions : gState.transfers;
+            const int64_t id = takeRandom(pool, rng);
+            if (id == 0) {
+                op = Op::Income;
+            } else {
+                const std::string path =
+                    (op == Op::DeleteTransaction ? "/transactions/" : "/transfers/") + std::to_string(id);
+                resp = co_await send(client, loop, drogon::Delete, path, nullptr, member.token, true);
+                record(op, resp);
+                continue;
+            }
+        }
+
+        Json::Value body;
+        std::string path;
+        if (op == Op::Transfer && accounts.size() > 1) {
+            const size_t from = rng() % accounts.size();
+            const size_t to = (from + 1 + rng() % (accounts.size() - 1)) % accounts.size();
+            body["account_from"] = static_cast<Json::Int64>(accounts[from]);
+            body["account_to"] = static_cast<Json::Int64>(accounts[to]);
+            body["amount"] = formatCents(cents(rng));
+            path = "/transfers";
+        } else {
+            op = op == Op::Transfer ? Op::Income : op;
+            body["id_account"] = static_cast<Json::Int64>(accounts[rng() % accounts.size()]);
+            body["amount"] = formatCents(cents(rng));
+            body["type"] = op == Op::Income ? "income" : "expense";
+            body["description"] = "stress";
+            path = "/transactions";
+        }
+        resp = co_await send(client, loop, drogon::Post, path, &body, member.token, true);
+        record(op, resp);
+        if (isSuccess(resp)) {
+            std::lock_guard<std::mutex> lock(gState.mutex);
+            (op == Op::Transfer ? gState.transfers : gState.transactions).push_back(jsonId(resp));
+        }
+    }
+}
+
+// Сумма значений метрики по всем меткам из текстового формата Prometheus
+Task<double> scrapeTotal(HttpClientPtr client, trantor::EventLoop *loop, const std::string &metric) {
+    auto resp = co_await send(client, loop, drogon::Get, "/metrics", nullptr, "");
+    if (!isSuccess(resp)) {
+        co_return 0;
+    }
+    double total = 0;
+    std::istringstream body{std::string(resp->body())};
+    std::string line;
+    while (std::getline(body, line)) {
+        if (line.compare(0, metric.size(), metric) != 0 ||
+            (line.size() > metric.size() && line[metric.size()] != '{' && line[metric.size()] != ' ')) {
+            continue;
+        }
+        const auto space = line.rfind(' ');
+        if (space != std::string::npos) {
+            total += std::atof(line.c_str() + space + 1);
+        }
+    }
+    co_return total;
+}
+
+struct Check {
+    bool consistent = false;
+    int64_t transactions = 0;
+    int64_t transfers = 0;
+    std::vector<std::string> mismatches;
+};
+
+// Баланс каждого счёта против начального баланса и журнала
+Task<Check> verify(HttpClientPtr client, trantor::EventLoop *loop) {
+    Check check;
+    const auto &token = gState.members.front().token;
+    std::map<int64_t, int64_t> expected;
+    for (auto id : gState.accounts) {
+        expected[id] = toCents(gOptions.startBalance);
+    }
+
+    auto txResp = co_await send(client, loop, drogon::Get, "/transactions", nullptr, token, true);
+    auto trResp = co_await send(client, loop, drogon::Get, "/transfers", nullptr, token, true);
+    if (!isSuccess(txResp) || !isSuccess(trResp) || !txResp->getJsonObject() ||
+        !trResp->getJsonObject()) {
+        check.mismatches.push_back("ledger request failed");
+        co_return check;
+    }
+    for (const auto &row : *txResp->getJsonObject()) {
+        auto it = expected.find(row["id_account"].asInt64());
+        if (it == expected.end()) {
+            continue;
+        }
+        ++check.transactions;
+        const int64_t amount = toCents(row["amount"].asString());
+        it->second += row["type"].asString() == "income" ? amount : -amount;
+    }
+    for (const auto &row : *trResp->getJsonObject()) {
+        auto from = expected.find(row["account_from"].asInt64());
+        auto to = expected.find(row["account_to"].asInt64());
+        if (from == expected.end() && to == expected.end()) {
+            continue;
+        }
+        ++check.transfers;
+        const int64_t amount = toCents(row["amount"].asString());
+        if (from != expected.end()) {
+            from->second -= amount;
+        }
+        if (to != expected.end()) {
+            to->second += amount;
+        }
+    }
+
+    for (const auto &[id, cents] : expected) {
+        auto resp = co_await send(client, loop, drogon::Get, "/accounts/" + std::to_string(id),
+                                  nullptr, token);
+        if (!isSuccess(resp) || !resp->getJsonObject()) {
+            check.mismatches.push_back("account " + std::to_string(id) + ": request failed");
+            continue;
+        }
+        const int64_t actual = toCents((*resp->getJsonObject())["balance"].asString());
+        if (actual != cents) {
+            check.mismatches.push_back("account " + std::to_string(id) + ": balance " +
+                                       formatCents(actual) + ", ledger " + formatCents(cents));
+        }
+    }
+    check.consistent = check.mismatches.empty();
+    co_return check;
+}
+
+template <typename T>
+T runSync(trantor::EventLoop *loop, std::function<Task<T>()> fn) {
+    std::promise<T> promise;
+    auto future = promise.get_future();
+    loop->queueInLoop([&promise, fn]() {
+        drogon::async_run([&promise, fn]() -> Task<> {
+            promise.set_value(co_await fn());
+        });
+    });
+    return future.get();
+}
+
+void parseArgs(int argc, char **argv) {
+    if (const char *url = std::getenv("FINANCIAL_MANAGER_URL")) {
+        gOptions.url = url;
+    }
+    bench::Args args(argc, argv,
+                     "[--url URL] [--members N] [--accounts N] [--ops N] [--threads N]\n"
+                     "          [--lanes N] [--start-balance AMOUNT] [--timeout-sec N]");
+    while (args.next()) {
+        if (args.is("--url")) {
+            gOptions.url = args.value();
+        } else if (args.is("--members")) {
+            gOptions.members = args.intValue(1);
+        } else if (args.is("--accounts")) {
+            gOptions.accounts = args.intValue(1);
+        } else if (args.is("--ops")) {
+            gOptions.ops = args.int64Value(1);
+        } else if (args.is("--threads")) {
+            gOptions.threads = args.intValue(1);
+        } else if (args.is("--lanes")) {
+            gOptions.lanes = args.intValue(1);
+        } else if (args.is("--start-balance")) {
+            gOptions.startBalance = args.value();
+        } else if (args.is("--timeout-sec")) {
+            gOptions.timeoutSec = args.doubleValue(0);
+        } else {
+            args.usage();
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    parseArgs(argc, argv);
+    if (gOptions.url.empty()) {
+        std::fprintf(stderr, "FINANCIAL_MANAGER_URL is not set, skipping\n");
+        return kSkipped;
+    }
+
+    trantor::EventLoopThreadPool pool(static_cast<size_t>(gOptions.threads), "stress");
+    pool.start();
+    auto *mainLoop = pool.getNextLoop();
+    auto client = drogon::HttpClient::newHttpClient(gOptions.url, mainLoop);
+
+    if (!runSync<bool>(mainLoop, [client, mainLoop]() { return setup(client, mainLoop); })) {
+        return 1;
+    }
+
+    const std::string retriesMetric = "db_transaction_retries_total";
+    const std::string failuresMetric = "db_transaction_failures_total";
+    auto scrape = [&](const std::string &metric) {
+        return runSync<double>(mainLoop, [client, mainLoop, metric]() {
+            return scrapeTotal(client, mainLoop, metric);
+        });
+    };
+    const double retriesBefore = scrape(retriesMetric);
+    const double failuresBefore = scrape(failuresMetric);
+
+    const auto start = Clock::now();
+    {
+        std::vector<std::future<void>> lanes;
+        for (int i = 0; i < gOptions.lanes; ++i) {
+            auto *loop = pool.getNextLoop();
+            lanes.push_back(std::async(std::launch::async, [i, loop]() {
+                runSync<bool>(loop, [i, loop]() -> Task<bool> {
+                    co_await lane(i, loop);
+                    co_return true;
+                });
+            }));
+        }
+        for (auto &f : lanes) {
+            f.get();
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const double retries = scrape(retriesMetric) - retriesBefore;
+    const double failures = scrape(failuresMetric) - failuresBefore;
+
+    // Списки могут читаться с реплики: даём ей догнать основную базу
+    Check check;
+    for (int attempt = 0; attempt < 10 && !check.consistent; ++attempt) {
+        if (attempt > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+        check = runSync<Check>(mainLoop, [client, mainLoop]() { return verify(client, mainLoop); });
+    }
+
+    int64_t total = 0;
+    std::string outcomes;
+    for (int i = 0; i < kOpCount; ++i) {
+        const auto &o = gState.outcomes[i];
+        total += o.ok + o.rejected + o.serverErrors + o.networkErrors;
+        char buf[256];
+        std::snprintf(buf, sizeof(buf),
+                      "%s\"%s\":{\"ok\":%lld,\"rejected\":%lld,\"5xx\":%lld,\"network_errors\":%lld}",
+                      i ? "," : "", kOpNames[i], static_cast<long long>(o.ok.load()),
+                      static_cast<long long>(o.rejected.load()),
+                      static_cast<long long>(o.serverErrors.load()),
+                      static_cast<long long>(o.networkErrors.load()));
+        outcomes += buf;
+    }
+    std::printf("{\"ops\":%lld,\"seconds\":%.2f,\"ops_per_sec\":%.1f,\"throttled\":%lld,"
+                "\"db_retries\":%.0f,\"db_failures\":%.0f,\"ledger_transactions\":%lld,"
+                "\"ledger_transfers\":%lld,\"consistent\":%s,\"outcomes\":{%s}}\n",
+                static_cast<long long>(total), seconds, static_cast<double>(total) / seconds,
+                static_cast<long long>(gState.throttled.load()), retries, failures,
+                static_cast<long long>(check.transactions), static_cast<long long>(check.transfers),
+                check.consistent ? "true" : "false", outcomes.c_str());
+    for (const auto &m : check.mismatches) {
+        std::fprintf(stderr, "invariant violated: %s\n", m.c_str());
+    }
+    return check.consistent ? 0 : 1;
+}
@@ -1,16 +1,25 @@
 #define DROGON_TEST_MAIN
 #include <drogon/drogon_test.h>
 #include <drogon/drogon.h>
+#include "TestEnv.h"
 
-DROGON_TEST(BasicTest)
-{
-    // Add your tests here
-}
-
-int main(int argc, char** argv) 
+int main(int argc, char** argv)
 {
     using namespace drogon;
 
+    // Одноразовая схема, миграции и настройка приложения до запуска loop
+    switch (test_env::prepare()) {
+    case test_env::Status::Skipped:
+        // 77 — код пропуска для ctest (SKIP_RETURN_CODE в CMakeLists.txt)
+        LOG_WARN << "FINANCIAL_MANAGER_TEST_CONFIG is not set, integration tests skipped";
+        return 77;
+    case test_env::Status::Failed:
+        test_env::teardown();
+        return 1;
+    case test_env::Status::Ready:
+        break;
+    }
+
     std::promise<void> p1;
     std::future<void> f1 = p1.get_future();
 
@@ -23,10 +32,11 @@ int main(int argc, char** argv)
 
     // The future is only satisfied after the event loop started
     f1.get();
-    int status = test::run(argc, argv);
+    int status = test_env::seed() ? test::run(argc, argv) : 1;
 
     // Ask the event loop to shutdown and wait
     app().getLoop()->queueInLoop([]() { app().quit(); });
     thr.join();
+    test_env::teardown();
     return status;
 }
@@ -0,0 +1,8 @@
+#define DROGON_TEST_MAIN
+#include <drogon/drogon_test.h>
+
+// Модульные тесты без БД и запущенного приложения
+int main(int argc, char** argv)
+{
+    return drogon::test::run(argc, argv);
+}
@@ -0,0 +1,81 @@
+#include "AppSetup.h"
+#include <drogon/drogon.h>
+#include <fstream>
+#include <stdexcept>
+#include "db/Admission.h"
+#include "db/CacheBus.h"
+#include "db/Deadline.h"
+#include "db/QueryMetrics.h"
+#include "db/ReadRouting.h"
+#include "db/SingleFlight.h"
+#include "utils/ClientIp.h"
+#include "utils/Log.h"
+#include "utils/LoginThrottle.h"
+#include "utils/PasswordUtils.h"
+#include "utils/RouteMetrics.h"
+
+bool finance::setupApp(const std::string &configPath) {
+    // Уровни модулей журнала и буферизованный вывод в stdout (custom_config.logging)
+    try {
+        slog::init(drogon::app().getCustomConfig()["logging"]);
+    } catch (const std::exception &e) {
+        LOG_ERROR << e.what();
+        return false;
+    }
+    // Чтения GET-обработчиков уходят на реплику из custom_config.read_replica
+    db::initReadRouting();
+    // Одинаковые одновременные семейные чтения объединяются в один запрос
+    db::initSingleFlight();
+    // Инвалидации кэшей рассылаются остальным экземплярам через LISTEN/NOTIFY
+    db::cacheBus::init(configPath);
+    // При переполнении пула соединений новые запросы получают 503, чтения — первыми
+    db::admission::init(configPath);
+    // Срок обработки запроса ограничивает запросы к БД (custom_config.deadlines)
+    db::deadline::init();
+    // Адрес клиента из X-Forwarded-For только от custom_config.trusted_proxies
+    security::configureTrustedProxies(drogon::app().getCustomConfig()["trusted_proxies"]);
+    // Паузы после неудачных попыток входа (custom_config.login_throttle)
+    security::throttle::init();
+    // Длительность, размер и статусы ответов по шаблонам маршрутов
+    route_metrics::init();
+    // Алгоритм и стоимость хешей паролей; устаревшие хеши пересчитываются при входе
+    try {
+        security::configurePasswordHash(drogon::app().getCustomConfig()["password_hash"]);
+    } catch (const std::exception &e) {
+        LOG_ERROR << e.what();
+        return false;
+    }
+    // Длительность профиля CPU ограничивается [1, max_seconds] (custom_config.profiler)
+    const auto &profiler = drogon::app().getCustomConfig()["profiler"];
+    if (profiler.isObject() && profiler.get("max_seconds", 30).asInt() < 1) {
+        LOG_ERROR << "custom_config.profiler.max_seconds must be at least 1";
+        return false;
+    }
+
+    // Метрики запросов к БД и маршрутов публикуются через PromExporter после старта плагинов
+    drogon::app().registerBeginningAdvice([]() {
+        db::metrics::registerCollectors();
+        route_metrics::registerCollectors();
+    });
+    return true;
+}
+
+Json::Value finance::configWithoutRateLimits(const std::string &configPath) {
+    std::ifstream in(configPath);
+    if (!in) {
+        throw std::runtime_error("Cannot open config " + configPath);
+    }
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    if (!Json::parseFromStream(builder, in, &root, &errs)) {
+        throw std::runtime_error("Cannot parse config " + configPath + ": " + errs);
+    }
+    for (auto &plugin : root["plugins"]) {
+        if (plugin["name"].asString() == "finance::RateLimiter") {
+            plugin["config"]["enabled"] = false;
+        }
+    }
+    root["custom_config"]["login_throttle"]["enabled"] = false;
+    return root;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <json/json.h>
+#include <string>
+
+namespace finance {
+
+// Подключает к приложению всё, что настраивается из custom_config:
+// журнал, маршрутизацию чтений, кэши, admission control, сроки запросов, паузы
+// входа, параметры хешей паролей и метрики. Вызывается после
+// loadConfigFile и до app().run() — из main и из интеграционных тестов.
+// Возвращает false, если конфигурация некорректна (причина пишется в лог).
+bool setupApp(const std::string &configPath);
+
+// Конфигурация из JSON-файла configPath для app().loadConfigJson с
+// отключёнными finance::RateLimiter и login_throttle: для локального прогона
+// нагрузочных инструментов (bench/, test/stress_main.cc), которые шлют все
+// запросы с одного адреса. Бросает std::runtime_error, если файл не читается.
+Json::Value configWithoutRateLimits(const std::string &configPath);
+
+}
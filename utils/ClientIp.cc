@@ -0,0 +1,59 @@
+#include "ClientIp.h"
+#include <drogon/drogon.h>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+
+std::unordered_set<std::string> gTrustedProxies;
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+bool trusted(std::string_view ip) {
+    return gTrustedProxies.count(std::string(ip)) > 0;
+}
+
+}
+
+void security::configureTrustedProxies(const Json::Value &config) {
+    gTrustedProxies.clear();
+    if (!config.isArray()) {
+        return;
+    }
+    for (const auto &ip : config) {
+        gTrustedProxies.insert(ip.asString());
+    }
+    if (!gTrustedProxies.empty()) {
+        LOG_INFO << "X-Forwarded-For is honored from " << gTrustedProxies.size()
+                 << " trusted proxies";
+    }
+}
+
+std::string security::clientIp(const drogon::HttpRequestPtr &req) {
+    std::string peer = req->peerAddr().toIp();
+    if (gTrustedProxies.empty() || !trusted(peer)) {
+        return peer;
+    }
+    const std::string &forwarded = req->getHeader("x-forwarded-for");
+    // Прокси дописывают адреса справа: идём от последнего, пропуская свои
+    std::string_view rest = forwarded;
+    std::string_view candidate;
+    while (!rest.empty()) {
+        const size_t comma = rest.rfind(',');
+        candidate = trim(comma == std::string_view::npos ? rest : rest.substr(comma + 1));
+        rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(0, comma);
+        if (!candidate.empty() && !trusted(candidate)) {
+            return std::string(candidate);
+        }
+    }
+    // Вся цепочка из доверенных прокси: берём самый левый адрес
+    return candidate.empty() ? peer : std::string(candidate);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+#include <drogon/HttpRequest.h>
+#include <jsoncpp/json/json.h>
+
+// Адрес клиента для ограничений по IP (RateLimiter, LoginThrottle).
+// X-Forwarded-For учитывается только от доверенных прокси из
+// custom_config.trusted_proxies: иначе клиент подставил бы в заголовок
+// произвольный адрес и обошёл бы ограничения.
+namespace security {
+
+// Список доверенных прокси; вызывается до app().run()
+void configureTrustedProxies(const Json::Value &config);
+
+// Адрес соединения, а если оно пришло от доверенного прокси — самый правый
+// адрес X-Forwarded-For, не принадлежащий доверенным прокси
+std::string clientIp(const drogon::HttpRequestPtr &req);
+
+}
@@ -0,0 +1,250 @@
+#include "CpuProfiler.h"
+#include <cxxabi.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// В старых glibc поле есть, а макроса нет
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace {
+
+constexpr int kMaxDepth = 48;
+constexpr size_t kMaxSamples = 1 << 15;
+// Кадры обработчика сигнала и трамплина sigreturn
+constexpr int kSkipFrames = 2;
+
+struct Sample {
+    pid_t tid;
+    int depth;
+    void *pcs[kMaxDepth];
+};
+
+// Состояние, доступное из обработчика сигнала: только атомики и буфер,
+// выделенный до взвода таймеров
+std::unique_ptr<Sample[]> gSamples;
+std::atomic<size_t> gNext{0};
+std::atomic<size_t> gDropped{0};
+std::atomic<bool> gActive{false};
+std::atomic<int> gInHandler{0};
+
+std::mutex gMutex;
+bool gRunning = false;
+bool gHandlerInstalled = false;
+std::vector<timer_t> gTimers;
+std::unordered_map<pid_t, std::string> gThreadNames;
+
+void onProfSignal(int, siginfo_t *, void *) {
+    const int savedErrno = errno;
+    // Пара с stop(): gInHandler++ затем чтение gActive против записи gActive
+    // затем чтения gInHandler. Без seq_cst обе стороны могут не увидеть друг
+    // друга, и буфер освободится во время записи выборки.
+    gInHandler.fetch_add(1, std::memory_order_seq_cst);
+    if (gActive.load(std::memory_order_seq_cst)) {
+        const size_t i = gNext.fetch_add(1, std::memory_order_relaxed);
+        if (i < kMaxSamples) {
+            auto &sample = gSamples[i];
+            sample.tid = static_cast<pid_t>(syscall(SYS_gettid));
+            sample.depth = backtrace(sample.pcs, kMaxDepth);
+        } else {
+            gDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    gInHandler.fetch_sub(1, std::memory_order_acq_rel);
+    errno = savedErrno;
+}
+
+std::string threadName(pid_t tid) {
+    std::ifstream in("/proc/self/task/" + std::to_string(tid) + "/comm");
+    std::string name;
+    std::getline(in, name);
+    return (name.empty() ? "thread" : name) + " [" + std::to_string(tid) + "]";
+}
+
+std::vector<pid_t> processThreads() {
+    std::vector<pid_t> tids;
+    if (DIR *dir = opendir("/proc/self/task")) {
+        while (dirent *entry = readdir(dir)) {
+            if (entry->d_name[0] >= '0' && entry->d_name[0] <= '9') {
+                tids.push_back(static_cast<pid_t>(std::atoi(entry->d_name)));
+            }
+        }
+        closedir(dir);
+    }
+    return tids;
+}
+
+// Часы CPU-времени потока по tid (MAKE_THREAD_CPUCLOCK из ядра: CPUCLOCK_SCHED
+// с флагом CPUCLOCK_PERTHREAD_MASK)
+clockid_t threadCpuClock(pid_t tid) {
+    return (~static_cast<clockid_t>(tid) << 3) | 6;
+}
+
+void deleteTimers() {
+    for (auto timer : gTimers) {
+        timer_delete(timer);
+    }
+    gTimers.clear();
+}
+
+// Для адресов возврата берём предыдущий байт, чтобы попасть в инструкцию
+// вызова, а не в следующую за ней строку (или в следующую функцию)
+std::string symbolize(void *pc, bool returnAddress) {
+    auto *addr = static_cast<char *>(pc) - (returnAddress ? 1 : 0);
+    Dl_info info{};
+    if (dladdr(addr, &info) && info.dli_sname) {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+        std::free(demangled);
+        return name;
+    }
+    char buf[32];
+    if (info.dli_fname && info.dli_fbase) {
+        const char *base = std::strrchr(info.dli_fname, '/');
+        std::snprintf(buf, sizeof(buf), "+0x%zx",
+                      static_cast<size_t>(addr - static_cast<char *>(info.dli_fbase)));
+        return std::string(base ? base + 1 : info.dli_fname) + buf;
+    }
+    std::snprintf(buf, sizeof(buf), "%p", pc);
+    return buf;
+}
+
+}
+
+cpu_profiler::StartResult cpu_profiler::start(int hz, std::string &error) {
+    std::lock_guard lock(gMutex);
+    if (gRunning) {
+        error = "CPU profile is already being captured";
+        return StartResult::Busy;
+    }
+
+    // Первый вызов backtrace загружает libgcc_s; в обработчике сигнала это
+    // делать нельзя
+    void *warmup[4];
+    backtrace(warmup, 4);
+
+    if (!gHandlerInstalled) {
+        // Обработчик остаётся установленным: сигнал, уже отправленный
+        // удаляемым таймером, не должен завершить процесс действием по умолчанию
+        struct sigaction action {};
+        action.sa_sigaction = onProfSignal;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, nullptr) != 0) {
+            error = std::string("sigaction failed: ") + std::strerror(errno);
+            return StartResult::Failed;
+        }
+        gHandlerInstalled = true;
+    }
+
+    gSamples = std::make_unique<Sample[]>(kMaxSamples);
+    gNext = 0;
+    gDropped = 0;
+    gThreadNames.clear();
+    gActive.store(true, std::memory_order_release);
+
+    const long periodNs = 1000000000L / std::max(1, hz);
+    itimerspec spec{};
+    spec.it_interval.tv_sec = periodNs / 1000000000L;
+    spec.it_interval.tv_nsec = periodNs % 1000000000L;
+    spec.it_value = spec.it_interval;
+
+    for (pid_t tid : processThreads()) {
+        sigevent event{};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event.sigev_notify_thread_id = tid;
+        timer_t timer;
+        // Поток мог завершиться после чтения /proc
+        if (timer_create(threadCpuClock(tid), &event, &timer) != 0) {
+            continue;
+        }
+        if (timer_settime(timer, 0, &spec, nullptr) != 0) {
+            timer_delete(timer);
+            continue;
+        }
+        gTimers.push_back(timer);
+        gThreadNames.emplace(tid, threadName(tid));
+    }
+
+    if (gTimers.empty()) {
+        gActive = false;
+        error = std::string("timer_create failed: ") + std::strerror(errno);
+        return StartResult::Failed;
+    }
+    gRunning = true;
+    return StartResult::Started;
+}
+
+cpu_profiler::Profile cpu_profiler::stop() {
+    std::lock_guard lock(gMutex);
+    Profile profile;
+    if (!gRunning) {
+        return profile;
+    }
+    deleteTimers();
+    gActive.store(false, std::memory_order_seq_cst);
+    while (gInHandler.load(std::memory_order_seq_cst) > 0) {
+        std::this_thread::yield();
+    }
+    gRunning = false;
+
+    const size_t count = std::min(gNext.load(), kMaxSamples);
+    profile.dropped = gDropped.load();
+    profile.threads = gThreadNames.size();
+
+    std::unordered_map<void *, std::string> symbols;
+    const auto symbolOf = [&symbols](void *pc, bool returnAddress) -> const std::string & {
+        auto it = symbols.find(pc);
+        if (it == symbols.end()) {
+            it = symbols.emplace(pc, symbolize(pc, returnAddress)).first;
+        }
+        return it->second;
+    };
+
+    std::map<std::string, size_t> stacks;
+    for (size_t i = 0; i < count; ++i) {
+        const auto &sample = gSamples[i];
+        if (sample.depth <= kSkipFrames) {
+            continue;
+        }
+        auto name = gThreadNames.find(sample.tid);
+        std::string stack = name != gThreadNames.end() ? name->second
+                                                       : "thread [" + std::to_string(sample.tid) + "]";
+        for (int f = sample.depth - 1; f >= kSkipFrames; --f) {
+            stack += ';';
+            stack += symbolOf(sample.pcs[f], f > kSkipFrames);
+        }
+        ++stacks[stack];
+        ++profile.samples;
+    }
+    gSamples.reset();
+
+    for (const auto &[stack, n] : stacks) {
+        profile.folded += stack;
+        profile.folded += ' ';
+        profile.folded += std::to_string(n);
+        profile.folded += '\n';
+    }
+    return profile;
+}
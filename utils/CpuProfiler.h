@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Выборочный профилировщик CPU без внешних зависимостей. На каждый поток
+// процесса ставится таймер его CPU-времени (timer_create с SIGEV_THREAD_ID),
+// по SIGPROF обработчик снимает стек прерванного потока. Поток, не
+// потребляющий CPU, выборок не даёт, поэтому перегруженный IO-поток виден
+// сразу. Потоки, созданные после start(), не профилируются.
+//
+// Результат — свёрнутые стеки (формат flamegraph.pl, speedscope, inferno).
+// Символы берутся через dladdr, поэтому исполняемый файл собирается с
+// экспортом символов (ENABLE_EXPORTS), иначе функции приложения будут
+// показаны смещениями.
+namespace cpu_profiler {
+
+enum class StartResult { Started, Busy, Failed };
+
+struct Profile {
+    // Строки "поток;внешняя функция;...;листовая функция число_выборок"
+    std::string folded;
+    size_t samples = 0;
+    // Выборки, не поместившиеся в буфер
+    size_t dropped = 0;
+    size_t threads = 0;
+};
+
+// Начинает сбор с частотой hz выборок в секунду CPU-времени каждого потока.
+// Одновременно идёт не больше одного профилирования.
+StartResult start(int hz, std::string &error);
+
+// Останавливает сбор и сворачивает стеки; пустой профиль, если сбор не шёл
+Profile stop();
+
+}
@@ -20,9 +20,11 @@ std::string jwt_utils::createToken(int64_t user_id, const std::string &email) {
         .sign(jwt::algorithm::hs256{JWT_SECRET});
 }
 
-std::optional<int64_t> jwt_utils::getUserIdFromRequest(const drogon::HttpRequestPtr &req) {
-    if (!req) return std::nullopt;
+namespace {
+
+const std::string kUserIdAttribute = "jwt_user_id";
 
+std::optional<int64_t> parseUserId(const drogon::HttpRequestPtr &req) {
     // 1) Authorization: Bearer <token> (проверяем оба варианта регистра)
     std::string token;
     auto auth = req->getHeader("authorization");
@@ -57,4 +59,20 @@ std::optional<int64_t> jwt_utils::getUserIdFromRequest(const drogon::HttpRequest
     } catch (...) {
         return std::nullopt;
     }
-}
\ No newline at end of file
+}
+
+}
+
+std::optional<int64_t> jwt_utils::getUserIdFromRequest(const drogon::HttpRequestPtr &req) {
+    if (!req) return std::nullopt;
+
+    // Токен проверяется один раз на запрос: результат запоминается в атрибутах,
+    // его используют и advices, и обработчик
+    auto attributes = req->attributes();
+    if (attributes->find(kUserIdAttribute)) {
+        return attributes->get<std::optional<int64_t>>(kUserIdAttribute);
+    }
+    auto userId = parseUserId(req);
+    attributes->insert(kUserIdAttribute, userId);
+    return userId;
+}
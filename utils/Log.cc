@@ -0,0 +1,217 @@
+#include "Log.h"
+#include <drogon/drogon.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+std::mutex gModulesMutex;
+
+std::map<std::string, std::unique_ptr<slog::Module>, std::less<>> &modules() {
+    static std::map<std::string, std::unique_ptr<slog::Module>, std::less<>> registry;
+    return registry;
+}
+
+int parseLevel(const std::string &name) {
+    static const std::map<std::string, slog::Level> levels{
+        {"TRACE", trantor::Logger::kTrace}, {"DEBUG", trantor::Logger::kDebug},
+        {"INFO", trantor::Logger::kInfo},   {"WARN", trantor::Logger::kWarn},
+        {"ERROR", trantor::Logger::kError}, {"FATAL", trantor::Logger::kFatal}};
+    auto it = levels.find(name);
+    if (it == levels.end()) {
+        throw std::invalid_argument("custom_config.logging: unknown log level '" + name + "'");
+    }
+    return static_cast<int>(it->second);
+}
+
+// Вывод в stdout из фонового потока: строки копируются в буфер под
+// мьютексом, запись в терминал или pipe не задерживает IO-потоки. Буфер
+// сбрасывается по интервалу, при заполнении на четверть и по вызову flush
+// из trantor. Сверх лимита строки отбрасываются с учётом.
+class AsyncStdout {
+public:
+    AsyncStdout(std::chrono::milliseconds interval, size_t maxBytes)
+        : interval_(interval), maxBytes_(maxBytes) {
+        std::thread([this] { run(); }).detach();
+    }
+
+    void output(const char *data, uint64_t len) {
+        std::lock_guard lock(mutex_);
+        if (direct_) {
+            writeAll(data, len);
+            return;
+        }
+        if (buffer_.size() + len > maxBytes_) {
+            ++dropped_;
+            return;
+        }
+        buffer_.append(data, len);
+        if (buffer_.size() >= maxBytes_ / 4) {
+            wake_.notify_one();
+        }
+    }
+
+    // writeMutex_ берётся до take(): иначе параллельный flush мог бы записать
+    // более новые строки раньше уже вынутых старых
+    void flush() {
+        std::lock_guard write(writeMutex_);
+        std::string chunk;
+        {
+            std::lock_guard lock(mutex_);
+            chunk = take();
+        }
+        writeAll(chunk.data(), chunk.size());
+    }
+
+    // После завершения main фоновый поток может не успеть: остаток пишется
+    // сразу, последующие строки — синхронно
+    void finish() {
+        flush();
+        std::lock_guard lock(mutex_);
+        direct_ = true;
+    }
+
+private:
+    void run() {
+        for (;;) {
+            {
+                std::unique_lock lock(mutex_);
+                wake_.wait_for(lock, interval_, [this] { return buffer_.size() >= maxBytes_ / 4; });
+            }
+            flush();
+        }
+    }
+
+    // Вызывается под mutex_
+    std::string take() {
+        std::string chunk;
+        chunk.swap(buffer_);
+        if (dropped_ > 0) {
+            chunk += "slog: dropped " + std::to_string(dropped_) +
+                     " log lines, stdout is slower than logging\n";
+            dropped_ = 0;
+        }
+        return chunk;
+    }
+
+    static void writeAll(const char *data, size_t len) {
+        while (len > 0) {
+            const ssize_t n = ::write(STDOUT_FILENO, data, len);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+    }
+
+    const std::chrono::milliseconds interval_;
+    const size_t maxBytes_;
+    std::mutex mutex_;
+    std::mutex writeMutex_;
+    std::condition_variable wake_;
+    std::string buffer_;
+    uint64_t dropped_ = 0;
+    bool direct_ = false;
+};
+
+// Объект не удаляется: trantor может писать в журнал до последнего
+// деструктора статических объектов
+AsyncStdout *gStdout = nullptr;
+
+bool needsQuotes(std::string_view value) {
+    return value.empty() || std::any_of(value.begin(), value.end(), [](char c) {
+        return c == ' ' || c == '"' || c == '=' || c == '\\' ||
+               static_cast<unsigned char>(c) < 0x20;
+    });
+}
+
+}
+
+slog::Module &slog::module(std::string_view name) {
+    std::lock_guard lock(gModulesMutex);
+    auto &registry = modules();
+    auto it = registry.find(name);
+    if (it == registry.end()) {
+        it = registry.emplace(std::string(name), std::make_unique<Module>(std::string(name))).first;
+    }
+    return *it->second;
+}
+
+void slog::init(const Json::Value &config) {
+    if (!config.isObject()) {
+        return;
+    }
+    const auto &levels = config["modules"];
+    for (const auto &name : levels.getMemberNames()) {
+        module(name).setLevel(parseLevel(levels[name].asString()));
+    }
+
+    // При заданном log_path Drogon уже пишет через AsyncFileLogger
+    if (!config.get("async_stdout", true).asBool() || !drogon::app().getLogPath().empty() ||
+        gStdout) {
+        return;
+    }
+    gStdout = new AsyncStdout(
+        std::chrono::milliseconds(std::max<int64_t>(1, config.get("flush_interval_ms", 200).asInt64())),
+        std::max<size_t>(4096, config.get("max_buffer_kb", 8192).asUInt64() * 1024));
+    trantor::Logger::setOutputFunction(
+        [](const char *data, uint64_t len) { gStdout->output(data, len); },
+        [] { gStdout->flush(); });
+    std::atexit([] { gStdout->finish(); });
+}
+
+slog::Line::Line(const Module &module, Level level, std::string_view event, const char *file, int line)
+    : level_(level), file_(file), line_(line) {
+    text_.reserve(128);
+    text_ += "event=";
+    text_ += event;
+    text_ += " module=";
+    text_ += module.name();
+}
+
+slog::Line::~Line() {
+    trantor::Logger(trantor::Logger::SourceFile(file_), line_, level_).stream() << text_;
+}
+
+slog::Line &slog::Line::raw(std::string_view key, std::string_view value) {
+    text_ += ' ';
+    text_ += key;
+    text_ += '=';
+    text_ += value;
+    return *this;
+}
+
+slog::Line &slog::Line::quoted(std::string_view key, std::string_view value) {
+    if (!needsQuotes(value)) {
+        return raw(key, value);
+    }
+    text_ += ' ';
+    text_ += key;
+    text_ += "=\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            text_ += '\\';
+            text_ += c;
+        } else if (c == '\n') {
+            text_ += "\\n";
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            text_ += ' ';
+        } else {
+            text_ += c;
+        }
+    }
+    text_ += '"';
+    return *this;
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace Json {
+class Value;
+}
+
+// Структурированный журнал: строка "event=<событие> module=<модуль> k=v ..."
+// через тот же вывод trantor, что и LOG_*. Уровень задаётся для каждого
+// модуля в custom_config.logging.modules (по умолчанию — общий log_level),
+// проверка уровня — одно атомарное чтение, аргументы при выключенном уровне
+// не вычисляются. Для горячих путей есть строки с ограничением частоты
+// (SLOG_RATE_LIMITED) и выборочные (SLOG_SAMPLED).
+//
+//   static slog::Module &kLog = slog::module("transactions");
+//   SLOG_INFO(kLog, "transaction_created").kv("user", userId).kv("account", accountId);
+//
+// Токены, пароли и email в журнал не пишутся.
+namespace slog {
+
+using Level = trantor::Logger::LogLevel;
+
+class Module {
+public:
+    explicit Module(std::string name) : name_(std::move(name)) {}
+
+    const std::string &name() const { return name_; }
+
+    bool enabled(Level level) const {
+        const int own = level_.load(std::memory_order_relaxed);
+        const int threshold = own >= 0 ? own : static_cast<int>(trantor::Logger::logLevel());
+        return static_cast<int>(level) >= threshold;
+    }
+
+    // -1 — общий уровень приложения
+    void setLevel(int level) { level_.store(level, std::memory_order_relaxed); }
+
+private:
+    std::string name_;
+    std::atomic<int> level_{-1};
+};
+
+// Модуль с именем name; один объект на имя за всё время работы
+Module &module(std::string_view name);
+
+// Уровни модулей и асинхронный вывод в stdout из custom_config.logging.
+// Вызывается до app().run(); бросает std::invalid_argument при неизвестном уровне.
+void init(const Json::Value &config);
+
+// Строка журнала; выводится в деструкторе
+class Line {
+public:
+    Line(const Module &module, Level level, std::string_view event, const char *file, int line);
+    ~Line();
+    Line(const Line &) = delete;
+    Line &operator=(const Line &) = delete;
+
+    template <typename T>
+    Line &kv(std::string_view key, const T &value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return raw(key, value ? "true" : "false");
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            return raw(key, std::to_string(value));
+        } else {
+            static_assert(std::is_convertible_v<const T &, std::string_view>,
+                          "slog::Line::kv accepts numbers and strings");
+            return quoted(key, value);
+        }
+    }
+
+    // Число строк, подавленных с прошлого вывода (только если их было больше 0)
+    Line &suppressed(uint64_t count) {
+        return count > 0 ? kv("suppressed", count) : *this;
+    }
+
+private:
+    Line &raw(std::string_view key, std::string_view value);
+    Line &quoted(std::string_view key, std::string_view value);
+
+    Level level_;
+    const char *file_;
+    int line_;
+    std::string text_;
+};
+
+// Не больше perSecond строк в секунду на место вызова; остальные считаются
+class RateLimit {
+public:
+    explicit RateLimit(int perSecond) : perSecond_(perSecond) {}
+
+    bool allow() {
+        const int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t window = window_.load(std::memory_order_relaxed);
+        if (window != second && window_.compare_exchange_strong(window, second)) {
+            count_.store(0, std::memory_order_relaxed);
+        }
+        if (count_.fetch_add(1, std::memory_order_relaxed) < perSecond_) {
+            return true;
+        }
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint64_t takeSuppressed() { return suppressed_.exchange(0, std::memory_order_relaxed); }
+
+private:
+    const int perSecond_;
+    std::atomic<int64_t> window_{0};
+    std::atomic<int> count_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+// Каждая every-я строка места вызова
+class Sampler {
+public:
+    explicit Sampler(uint64_t every) : every_(every > 0 ? every : 1) {}
+
+    bool take() { return counter_.fetch_add(1, std::memory_order_relaxed) % every_ == 0; }
+    uint64_t every() const { return every_; }
+
+private:
+    const uint64_t every_;
+    std::atomic<uint64_t> counter_{0};
+};
+
+}
+
+#define SLOG(module, level, event)                                                     \
+    if (!(module).enabled(level))                                                      \
+        ;                                                                              \
+    else                                                                               \
+        ::slog::Line((module), (level), (event), __FILE__, __LINE__)
+
+#define SLOG_DEBUG(module, event) SLOG(module, ::trantor::Logger::kDebug, event)
+#define SLOG_INFO(module, event) SLOG(module, ::trantor::Logger::kInfo, event)
+#define SLOG_WARN(module, event) SLOG(module, ::trantor::Logger::kWarn, event)
+#define SLOG_ERROR(module, event) SLOG(module, ::trantor::Logger::kError, event)
+
+// Не больше perSecond строк в секунду; в выведенной строке — suppressed=N
+// подавленных с прошлого вывода
+#define SLOG_RATE_LIMITED(module, level, event, perSecond)                              \
+    if (static ::slog::RateLimit slogRateLimit_{perSecond};                            \
+        !(module).enabled(level) || !slogRateLimit_.allow())                           \
+        ;                                                                              \
+    else                                                                               \
+        ::slog::Line((module), (level), (event), __FILE__, __LINE__)                   \
+            .suppressed(slogRateLimit_.takeSuppressed())
+
+// Каждая everyN-я строка; в выведенной строке — sample_every=everyN
+#define SLOG_SAMPLED(module, level, event, everyN)                                      \
+    if (static ::slog::Sampler slogSampler_{everyN};                                    \
+        !(module).enabled(level) || !slogSampler_.take())                              \
+        ;                                                                              \
+    else                                                                               \
+        ::slog::Line((module), (level), (event), __FILE__, __LINE__)                   \
+            .kv("sample_every", slogSampler_.every())
@@ -0,0 +1,213 @@
+#include "LoginThrottle.h"
+#include <drogon/drogon.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ThrottleConfig {
+    bool enabled = true;
+    int freeFailuresPerEmail = 3;
+    int freeFailuresPerIp = 20;
+    double baseDelaySec = 1;
+    double maxDelaySec = 900;
+    // Счётчик забывается, если неудач не было дольше окна
+    Clock::duration window = std::chrono::minutes(15);
+    size_t maxEntriesPerShard = 100000 / 16;
+};
+
+ThrottleConfig gConfig;
+
+struct Entry {
+    int failures = 0;
+    // Разрешённые попытки, ещё не получившие результат
+    int inFlight = 0;
+    Clock::time_point lastFailure;
+    Clock::time_point blockedUntil;
+};
+
+struct alignas(64) Shard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+};
+
+constexpr size_t kShards = 16;
+std::array<Shard, kShards> gShards;
+
+// Ключи email и IP разделены префиксом; email без учёта регистра
+uint64_t emailKey(const std::string &email) {
+    std::string key = "e:" + email;
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return std::hash<std::string>{}(key);
+}
+
+uint64_t ipKey(const std::string &ip) {
+    return std::hash<std::string>{}("i:" + ip);
+}
+
+Shard &shardOf(uint64_t key) {
+    return gShards[(key ^ (key >> 32)) % kShards];
+}
+
+Clock::duration delayFor(int excess) {
+    const double delay = std::min(gConfig.maxDelaySec,
+                                  gConfig.baseDelaySec * std::pow(2.0, excess - 1));
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(delay));
+}
+
+// Освобождает место в переполненном шарде: сначала забытые записи,
+// затем запись с самой давней неудачей. Записи с попытками в полёте
+// не трогаются, пока есть другие.
+void evict(Shard &shard, Clock::time_point now) {
+    for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+        if (it->second.inFlight == 0 && now - it->second.lastFailure > gConfig.window &&
+            it->second.blockedUntil <= now) {
+            it = shard.entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (shard.entries.size() < gConfig.maxEntriesPerShard) {
+        return;
+    }
+    auto oldest = std::min_element(shard.entries.begin(), shard.entries.end(),
+                                   [](const auto &a, const auto &b) {
+                                       const bool aBusy = a.second.inFlight > 0;
+                                       const bool bBusy = b.second.inFlight > 0;
+                                       if (aBusy != bBusy) {
+                                           return bBusy;
+                                       }
+                                       return a.second.lastFailure < b.second.lastFailure;
+                                   });
+    shard.entries.erase(oldest);
+}
+
+// Пауза до следующей попытки; 0 — попытка разрешена и занимает место.
+// Неудачи и попытки в полёте вместе не превышают freeFailures; после
+// исчерпания бюджета в полёте может быть только одна попытка, и она сразу
+// занимает следующий интервал паузы.
+double acquire(uint64_t key, int freeFailures, Clock::time_point now) {
+    auto &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.entries.size() >= gConfig.maxEntriesPerShard && !shard.entries.count(key)) {
+        evict(shard, now);
+    }
+    auto &entry = shard.entries[key];
+    if (entry.blockedUntil > now) {
+        return std::chrono::duration<double>(entry.blockedUntil - now).count();
+    }
+    if (entry.failures > 0 && now - entry.lastFailure > gConfig.window) {
+        entry.failures = 0;
+    }
+    if (entry.failures + entry.inFlight >= freeFailures) {
+        if (entry.inFlight > 0) {
+            // Ждём результата уже разрешённых попыток
+            const int excess = std::max(1, entry.failures + entry.inFlight - freeFailures + 1);
+            return std::chrono::duration<double>(delayFor(excess)).count();
+        }
+        entry.blockedUntil = now + delayFor(entry.failures - freeFailures + 1);
+    }
+    ++entry.inFlight;
+    return 0;
+}
+
+// Снимает попытку с учёта: failed — неудача, success — сброс счётчика
+void release(uint64_t key, int freeFailures, Clock::time_point now, bool failed, bool success) {
+    auto &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        return;
+    }
+    auto &entry = it->second;
+    entry.inFlight = std::max(0, entry.inFlight - 1);
+    if (success) {
+        entry.failures = 0;
+        entry.blockedUntil = {};
+    } else if (failed) {
+        if (entry.failures > 0 && now - entry.lastFailure > gConfig.window) {
+            entry.failures = 0;
+        }
+        ++entry.failures;
+        entry.lastFailure = now;
+        const int excess = entry.failures - freeFailures;
+        if (excess > 0) {
+            entry.blockedUntil = now + delayFor(excess);
+        }
+    }
+    if (entry.inFlight == 0 && entry.failures == 0) {
+        shard.entries.erase(it);
+    }
+}
+
+}
+
+void security::throttle::init() {
+    const auto &cfg = drogon::app().getCustomConfig()["login_throttle"];
+    if (!cfg.isObject()) {
+        return;
+    }
+    gConfig.enabled = cfg.get("enabled", gConfig.enabled).asBool();
+    gConfig.freeFailuresPerEmail =
+        cfg.get("free_failures_per_email", gConfig.freeFailuresPerEmail).asInt();
+    gConfig.freeFailuresPerIp = cfg.get("free_failures_per_ip", gConfig.freeFailuresPerIp).asInt();
+    gConfig.baseDelaySec = cfg.get("base_delay_ms", 1000).asDouble() / 1000.0;
+    gConfig.maxDelaySec = cfg.get("max_delay_sec", gConfig.maxDelaySec).asDouble();
+    gConfig.window = std::chrono::seconds(cfg.get("window_sec", 900).asInt64());
+    gConfig.maxEntriesPerShard =
+        std::max<size_t>(1, cfg.get("max_entries", 100000).asUInt64() / kShards);
+}
+
+security::throttle::Attempt::Attempt(const std::string &email, const std::string &ip)
+    : emailKey_(::emailKey(email)), ipKey_(::ipKey(ip)) {
+    if (!gConfig.enabled) {
+        return;
+    }
+    const auto now = Clock::now();
+    wait_ = acquire(emailKey_, gConfig.freeFailuresPerEmail, now);
+    if (wait_ > 0) {
+        return;
+    }
+    wait_ = acquire(ipKey_, gConfig.freeFailuresPerIp, now);
+    if (wait_ > 0) {
+        release(emailKey_, gConfig.freeFailuresPerEmail, now, false, false);
+        return;
+    }
+    reserved_ = true;
+}
+
+security::throttle::Attempt::~Attempt() {
+    if (reserved_) {
+        const auto now = Clock::now();
+        release(emailKey_, gConfig.freeFailuresPerEmail, now, false, false);
+        release(ipKey_, gConfig.freeFailuresPerIp, now, false, false);
+    }
+}
+
+void security::throttle::Attempt::failed() {
+    if (!std::exchange(reserved_, false)) {
+        return;
+    }
+    const auto now = Clock::now();
+    release(emailKey_, gConfig.freeFailuresPerEmail, now, true, false);
+    release(ipKey_, gConfig.freeFailuresPerIp, now, true, false);
+}
+
+void security::throttle::Attempt::succeeded() {
+    if (!std::exchange(reserved_, false)) {
+        return;
+    }
+    const auto now = Clock::now();
+    release(emailKey_, gConfig.freeFailuresPerEmail, now, false, true);
+    release(ipKey_, gConfig.freeFailuresPerIp, now, false, false);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Защита проверки пароля от перебора. Неудачные попытки считаются отдельно
+// по email и по IP; после нескольких бесплатных попыток следующая разрешается
+// только через паузу, удваивающуюся с каждой новой неудачей. Проверка
+// выполняется до PBKDF2, поэтому перебор не расходует CPU на хеширование.
+// Счётчики общие для всех IO-потоков, их число ограничено. При
+// login_throttle.enabled: false попытки не ограничиваются.
+namespace security::throttle {
+
+// Настройки из custom_config.login_throttle; вызывается до app().run()
+void init();
+
+// Попытка входа. Конструктор проверяет паузы по email и по IP и, если
+// попытка разрешена, занимает в их счётчиках место до её результата:
+// неудачи плюс попытки в полёте не превышают бесплатный бюджет, поэтому
+// одновременные запросы с одним ключом не хешируют пароль параллельно.
+// Место освобождается в failed()/succeeded() или, если результата нет
+// (ошибка, неприменимый запрос), в деструкторе.
+class Attempt {
+public:
+    Attempt(const std::string &email, const std::string &ip);
+    ~Attempt();
+
+    Attempt(const Attempt &) = delete;
+    Attempt &operator=(const Attempt &) = delete;
+
+    // Через сколько секунд можно повторить (0 — попытка разрешена)
+    double retryAfter() const { return wait_; }
+
+    // Неверный пароль (или несуществующий email)
+    void failed();
+
+    // Успешный вход: сбрасывает счётчик email
+    void succeeded();
+
+private:
+    uint64_t emailKey_;
+    uint64_t ipKey_;
+    double wait_ = 0;
+    bool reserved_ = false;
+};
+
+}
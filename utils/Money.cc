@@ -0,0 +1,18 @@
+#include "Money.h"
+#include <charconv>
+
+double money::parseAmount(const std::string &s) {
+    try {
+        return std::stod(s);
+    } catch (...) {
+        return 0.0;
+    }
+}
+
+std::string money::formatAmount(double value) {
+    // Без ostringstream: to_chars не зависит от локали и не выделяет память.
+    // Буфера хватает на любой double в фиксированной записи (до 309 цифр).
+    char buf[400];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, 2);
+    return std::string(buf, result.ptr);
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+
+// Суммы и балансы хранятся в БД как NUMERIC и приходят строками
+namespace money {
+    // Строка -> число; для некорректной строки 0
+    double parseAmount(const std::string &s);
+
+    // Число -> строка с двумя знаками после точки, как printf("%.2f")
+    std::string formatAmount(double value);
+}
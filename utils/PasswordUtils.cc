@@ -1,10 +1,36 @@
 #include "PasswordUtils.h"
+#include <openssl/crypto.h>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <stdexcept>
 #include <iomanip>
 #include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr size_t kHashLen = 32;
+// Стоимость хешей старого формата "<соль>$<хеш>"
+constexpr int kLegacyIterations = 100000;
+
+enum class Algorithm { Pbkdf2Sha256, Scrypt };
+
+struct HashParams {
+    Algorithm algorithm = Algorithm::Pbkdf2Sha256;
+    int iterations = kLegacyIterations;
+    int scryptLogN = 15;
+    int scryptR = 8;
+    int scryptP = 1;
+    bool legacy = false;
+};
+
+// Параметры новых хешей; меняются только при старте
+HashParams gCurrent;
+
+}
 
 static std::string bytesToHex(const unsigned char *bytes, size_t len) {
     std::stringstream ss;
@@ -23,37 +49,160 @@ static std::string generateSalt() {
     return bytesToHex(salt, 16);
 }
 
+// Солью служит hex-строка целиком, как и в старом формате
+static bool derive(const HashParams &params, const std::string &password,
+                   const std::string &salt, unsigned char *out) {
+    const auto *saltBytes = reinterpret_cast<const unsigned char *>(salt.c_str());
+    if (params.algorithm == Algorithm::Scrypt) {
+        const uint64_t n = uint64_t{1} << params.scryptLogN;
+        const uint64_t r = static_cast<uint64_t>(params.scryptR);
+        const uint64_t p = static_cast<uint64_t>(params.scryptP);
+        // Память под V (128·r·N) и B (128·r·p) с запасом
+        const uint64_t maxMem = 128 * r * (n + p + 2) + 1024;
+        return EVP_PBE_scrypt(password.c_str(), password.size(), saltBytes, salt.size(),
+                              n, r, p, maxMem, out, kHashLen) == 1;
+    }
+    return PKCS5_PBKDF2_HMAC(password.c_str(), password.size(), saltBytes, salt.size(),
+                             params.iterations, EVP_sha256(), kHashLen, out) == 1;
+}
+
+// "ln=15,r=8,p=1" -> значения по ключам; неизвестные ключи — ошибка
+static bool parseScryptParams(const std::string &text, HashParams &params) {
+    std::stringstream ss(text);
+    std::string item;
+    int seen = 0;
+    while (std::getline(ss, item, ',')) {
+        auto eq = item.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        const std::string key = item.substr(0, eq);
+        int value = 0;
+        try {
+            value = std::stoi(item.substr(eq + 1));
+        } catch (...) {
+            return false;
+        }
+        if (key == "ln") {
+            params.scryptLogN = value;
+        } else if (key == "r") {
+            params.scryptR = value;
+        } else if (key == "p") {
+            params.scryptP = value;
+        } else {
+            return false;
+        }
+        ++seen;
+    }
+    return seen == 3 && params.scryptLogN > 0 && params.scryptLogN < 32 &&
+           params.scryptR > 0 && params.scryptP > 0;
+}
+
+static bool parseHash(const std::string &hash, HashParams &params,
+                      std::string &salt, std::string &digest) {
+    params = HashParams{};
+    if (hash.empty() || hash[0] != '$') {
+        // Старый формат "<соль>$<хеш>"
+        size_t pos = hash.find('$');
+        if (pos == std::string::npos) return false;
+        params.legacy = true;
+        salt = hash.substr(0, pos);
+        digest = hash.substr(pos + 1);
+        return true;
+    }
+
+    std::vector<std::string> parts;
+    std::stringstream ss(hash.substr(1));
+    std::string part;
+    while (std::getline(ss, part, '$')) {
+        parts.push_back(part);
+    }
+    if (parts.size() != 4) return false;
+    salt = parts[2];
+    digest = parts[3];
+
+    if (parts[0] == "pbkdf2-sha256") {
+        if (parts[1].rfind("i=", 0) != 0) return false;
+        try {
+            params.iterations = std::stoi(parts[1].substr(2));
+        } catch (...) {
+            return false;
+        }
+        return params.iterations > 0;
+    }
+    if (parts[0] == "scrypt") {
+        params.algorithm = Algorithm::Scrypt;
+        return parseScryptParams(parts[1], params);
+    }
+    return false;
+}
+
+void security::configurePasswordHash(const Json::Value &config) {
+    if (!config.isObject()) {
+        return;
+    }
+    HashParams params;
+    const std::string algorithm = config.get("algorithm", "pbkdf2-sha256").asString();
+    if (algorithm == "scrypt") {
+        params.algorithm = Algorithm::Scrypt;
+    } else if (algorithm != "pbkdf2-sha256") {
+        throw std::invalid_argument("Unknown password hash algorithm: " + algorithm);
+    }
+    params.iterations = std::max(1, config.get("pbkdf2_iterations", params.iterations).asInt());
+    params.scryptLogN = std::clamp(config.get("scrypt_log_n", params.scryptLogN).asInt(), 1, 31);
+    params.scryptR = std::max(1, config.get("scrypt_r", params.scryptR).asInt());
+    params.scryptP = std::max(1, config.get("scrypt_p", params.scryptP).asInt());
+    gCurrent = params;
+}
+
 std::string security::hashPassword(const std::string &password) {
     std::string salt = generateSalt();
-    const unsigned char *pass = reinterpret_cast<const unsigned char *>(password.c_str());
-    unsigned char hash[32];
+    unsigned char hash[kHashLen];
 
-    if (!PKCS5_PBKDF2_HMAC(
-        reinterpret_cast<const char *>(pass), password.size(),
-        reinterpret_cast<const unsigned char *>(salt.c_str()), salt.size(),
-        100000, EVP_sha256(), 32, hash)) {
-        throw std::runtime_error("PBKDF2 failed");
+    if (!derive(gCurrent, password, salt, hash)) {
+        throw std::runtime_error("Password hashing failed");
     }
 
-    return salt + "$" + bytesToHex(hash, 32);
+    std::string out;
+    if (gCurrent.algorithm == Algorithm::Scrypt) {
+        out = "$scrypt$ln=" + std::to_string(gCurrent.scryptLogN) +
+              ",r=" + std::to_string(gCurrent.scryptR) +
+              ",p=" + std::to_string(gCurrent.scryptP);
+    } else {
+        out = "$pbkdf2-sha256$i=" + std::to_string(gCurrent.iterations);
+    }
+    return out + "$" + salt + "$" + bytesToHex(hash, kHashLen);
 }
 
 bool security::verifyPassword(const std::string &password, const std::string &hash) {
-    size_t pos = hash.find('$');
-    if (pos == std::string::npos) return false;
-    std::string salt = hash.substr(0, pos);
-    std::string storedHash = hash.substr(pos + 1);
-
-    const unsigned char *pass = reinterpret_cast<const unsigned char *>(password.c_str());
-    unsigned char out[32];
-
-    if (!PKCS5_PBKDF2_HMAC(
-        reinterpret_cast<const char *>(pass), password.size(),
-        reinterpret_cast<const unsigned char *>(salt.c_str()), salt.size(),
-        100000, EVP_sha256(), 32, out)) {
+    HashParams params;
+    std::string salt;
+    std::string storedHash;
+    if (!parseHash(hash, params, salt, storedHash)) return false;
+
+    unsigned char out[kHashLen];
+    if (!derive(params, password, salt, out)) {
         return false;
     }
 
-    std::string computedHex = bytesToHex(out, 32);
-    return storedHash == computedHex;
-}
\ No newline at end of file
+    std::string computedHex = bytesToHex(out, kHashLen);
+    return computedHex.size() == storedHash.size() &&
+           CRYPTO_memcmp(computedHex.data(), storedHash.data(), computedHex.size()) == 0;
+}
+
+bool security::needsRehash(const std::string &hash) {
+    HashParams params;
+    std::string salt;
+    std::string digest;
+    if (!parseHash(hash, params, salt, digest) || params.legacy) {
+        return true;
+    }
+    if (params.algorithm != gCurrent.algorithm) {
+        return true;
+    }
+    if (params.algorithm == Algorithm::Scrypt) {
+        return params.scryptLogN != gCurrent.scryptLogN || params.scryptR != gCurrent.scryptR ||
+               params.scryptP != gCurrent.scryptP;
+    }
+    return params.iterations != gCurrent.iterations;
+}
@@ -1,7 +1,23 @@
 #pragma once
 #include <string>
+#include <jsoncpp/json/json.h>
 
+// Формат хеша: $<алгоритм>$<параметры>$<соль hex>$<хеш hex>
+//   $pbkdf2-sha256$i=<итерации>$...
+//   $scrypt$ln=<log2 N>,r=<r>,p=<p>$...
+// Старый формат "<соль>$<хеш>" читается как PBKDF2-SHA256 со 100000 итераций.
 namespace security {
+    // Алгоритм и стоимость новых хешей из custom_config.password_hash:
+    // algorithm (pbkdf2-sha256 или scrypt), pbkdf2_iterations, scrypt_log_n,
+    // scrypt_r, scrypt_p. Вызывается до app().run().
+    void configurePasswordHash(const Json::Value &config);
+
     std::string hashPassword(const std::string &password);
+
+    // Параметры проверки берутся из самого хеша
     bool verifyPassword(const std::string &password, const std::string &hash);
-}
\ No newline at end of file
+
+    // Хеш записан в старом формате или с другим алгоритмом либо стоимостью,
+    // чем задано сейчас
+    bool needsRehash(const std::string &hash);
+}
@@ -0,0 +1,160 @@
+#include "RouteMetrics.h"
+#include <drogon/drogon.h>
+#include <drogon/plugins/PromExporter.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Gauge.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using drogon::monitoring::Collector;
+using drogon::monitoring::Counter;
+using drogon::monitoring::Gauge;
+using drogon::monitoring::Histogram;
+
+namespace {
+
+const std::string kRouteAttribute = "route_metrics";
+
+// Те же границы, что у db_query_duration_seconds: время маршрута и его
+// запросов к БД сравниваются по одним корзинам
+const std::vector<double> kLatencyBuckets{
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5};
+// От короткого JSON-объекта до больших семейных списков и страниц
+const std::vector<double> kSizeBuckets{
+    128, 512, 2048, 8192, 32768, 131072, 524288, 2097152};
+
+const std::array<std::string, 5> kStatusClasses{"1xx", "2xx", "3xx", "4xx", "5xx"};
+
+const std::shared_ptr<Collector<Histogram>> &durationCollector() {
+    static const auto collector = std::make_shared<Collector<Histogram>>(
+        "http_request_duration_seconds",
+        "Request handling time by method and route pattern",
+        std::vector<std::string>{"method", "route"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Histogram>> &sizeCollector() {
+    static const auto collector = std::make_shared<Collector<Histogram>>(
+        "http_response_size_bytes",
+        "Response body size by method and route pattern",
+        std::vector<std::string>{"method", "route"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Counter>> &responsesCollector() {
+    static const auto collector = std::make_shared<Collector<Counter>>(
+        "http_responses_total",
+        "Responses by method, route pattern and status class",
+        std::vector<std::string>{"method", "route", "status_class"});
+    return collector;
+}
+
+const std::shared_ptr<Collector<Gauge>> &inFlightCollector() {
+    static const auto collector = std::make_shared<Collector<Gauge>>(
+        "http_requests_in_flight",
+        "Requests routed but not yet answered by method and route pattern",
+        std::vector<std::string>{"method", "route"});
+    return collector;
+}
+
+// Ряды одного маршрута. Ищутся в коллекторах один раз, дальше запрос
+// обращается к ним без сборки меток и блокировок коллектора.
+struct RouteSeries {
+    std::shared_ptr<Histogram> duration;
+    std::shared_ptr<Histogram> size;
+    std::shared_ptr<Gauge> inFlight;
+    std::array<std::shared_ptr<Counter>, 5> responses;
+};
+
+std::mutex gSeriesMutex;
+std::unordered_map<std::string, std::shared_ptr<RouteSeries>> gSeries;
+
+std::shared_ptr<RouteSeries> seriesFor(const drogon::HttpRequestPtr &req) {
+    const std::string method(req->methodString());
+    const std::string route(req->getMatchedPathPattern());
+    const std::string key = method + " " + route;
+
+    std::lock_guard lock(gSeriesMutex);
+    auto &series = gSeries[key];
+    if (!series) {
+        series = std::make_shared<RouteSeries>();
+        const std::vector<std::string> labels{method, route};
+        series->duration = durationCollector()->metric(labels, kLatencyBuckets);
+        series->size = sizeCollector()->metric(labels, kSizeBuckets);
+        series->inFlight = inFlightCollector()->metric(labels);
+        for (size_t i = 0; i < kStatusClasses.size(); ++i) {
+            series->responses[i] =
+                responsesCollector()->metric({method, route, kStatusClasses[i]});
+        }
+    }
+    return series;
+}
+
+// Запрос в работе. Снимается при отправке ответа, а если ответа не будет
+// (соединение закрыто раньше) — при уничтожении запроса вместе с атрибутом.
+class InFlight {
+public:
+    explicit InFlight(std::shared_ptr<RouteSeries> series) : series_(std::move(series)) {
+        series_->inFlight->increment();
+    }
+    ~InFlight() { series_->inFlight->decrement(); }
+    InFlight(const InFlight &) = delete;
+    InFlight &operator=(const InFlight &) = delete;
+
+    RouteSeries &series() const { return *series_; }
+
+private:
+    std::shared_ptr<RouteSeries> series_;
+};
+
+}
+
+void route_metrics::init() {
+    // Наблюдатели вызываются до advices с ответом, поэтому 429 от
+    // RateLimiter и 503 от admission control тоже попадают в метрики
+    drogon::app().registerPostRoutingAdvice([](const drogon::HttpRequestPtr &req) {
+        if (req->getMatchedPathPattern().empty()) {
+            return;
+        }
+        req->attributes()->insert(kRouteAttribute, std::make_shared<InFlight>(seriesFor(req)));
+    });
+
+    drogon::app().registerPreSendingAdvice(
+        [](const drogon::HttpRequestPtr &req, const drogon::HttpResponsePtr &resp) {
+            if (!req->attributes()->find(kRouteAttribute)) {
+                return;
+            }
+            auto inFlight = req->attributes()->get<std::shared_ptr<InFlight>>(kRouteAttribute);
+            req->attributes()->erase(kRouteAttribute);
+
+            // С момента разбора запроса: учитываются и advices до маршрутизации
+            const auto elapsedUs = trantor::Date::date().microSecondsSinceEpoch() -
+                                   req->creationDate().microSecondsSinceEpoch();
+            auto &series = inFlight->series();
+            series.duration->observe(static_cast<double>(elapsedUs) / 1e6);
+            series.size->observe(static_cast<double>(resp->body().size()));
+
+            const int status = static_cast<int>(resp->statusCode());
+            if (status >= 100 && status < 600) {
+                series.responses[status / 100 - 1]->increment();
+            }
+        });
+}
+
+void route_metrics::registerCollectors() {
+    auto exporter = drogon::app().getPlugin<drogon::plugin::PromExporter>();
+    if (!exporter) {
+        LOG_WARN << "PromExporter plugin is not enabled, route metrics are not exported";
+        return;
+    }
+    exporter->registerCollector(durationCollector());
+    exporter->registerCollector(sizeCollector());
+    exporter->registerCollector(responsesCollector());
+    exporter->registerCollector(inFlightCollector());
+}
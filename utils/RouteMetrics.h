@@ -0,0 +1,18 @@
+#pragma once
+
+// Метрики HTTP-маршрутов для PromExporter: длительность обработки, размер
+// ответа, число ответов по классу статуса и запросы в работе. Метки —
+// метод и шаблон маршрута из ADD_METHOD_TO (например,
+// /transactions/{transactionId}), а не фактический путь, поэтому число
+// рядов ограничено числом маршрутов. Запросы, не попавшие ни в один
+// маршрут контроллеров, не учитываются.
+namespace route_metrics {
+
+// Регистрирует advices, снимающие метрики. Вызывается до app().run().
+void init();
+
+// Регистрирует коллекторы в плагине PromExporter (/metrics).
+// Вызывать после инициализации плагинов, например из registerBeginningAdvice.
+void registerCollectors();
+
+}